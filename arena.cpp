@@ -0,0 +1,98 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kSlabSize = 64 * 1024;
+
+}  // namespace
+
+SlabPool::SlabPool(size_t slot_size)
+    : slot_size_(slot_size), free_list_(nullptr), bump_(nullptr), end_(nullptr) {
+}
+
+SlabPool::~SlabPool() {
+    for (char* slab : slabs_) {
+        ::operator delete(slab);
+    }
+}
+
+void SlabPool::Grow() {
+    size_t slots = kSlabSize / slot_size_;
+    char* slab = static_cast<char*>(::operator new(slots * slot_size_));
+    slabs_.push_back(slab);
+    bump_ = slab;
+    end_ = slab + slots * slot_size_;
+}
+
+void* SlabPool::AllocateRun(size_t max_count, size_t* count) {
+    if (bump_ == end_) {
+        // Freed slots come before new slabs, even though they are scattered.
+        if (free_list_) {
+            *count = 1;
+            return Allocate();
+        }
+        Grow();
+    }
+    *count = std::min(max_count, static_cast<size_t>(end_ - bump_) / slot_size_);
+    void* run = bump_;
+    bump_ += *count * slot_size_;
+    return run;
+}
+
+void SlabPool::Absorb(SlabPool* other) {
+    slabs_.insert(slabs_.end(), other->slabs_.begin(), other->slabs_.end());
+    other->slabs_.clear();
+    // The longer bump region is kept, the other one is cut into free slots.
+    if (end_ - bump_ < other->end_ - other->bump_) {
+        std::swap(bump_, other->bump_);
+        std::swap(end_, other->end_);
+    }
+    for (char* slot = other->bump_; slot != other->end_; slot += slot_size_) {
+        Free(slot);
+    }
+    while (other->free_list_) {
+        FreeSlot* slot = other->free_list_;
+        other->free_list_ = slot->next;
+        Free(slot);
+    }
+    other->bump_ = other->end_ = nullptr;
+}
+
+SlabPool* Arena::Pool(uint8_t size_class) {
+    if (size_class == kUnpooled) {
+        throw std::logic_error("arena: unpooled size class must be allocated by the caller");
+    }
+    if (!pools_[size_class]) {
+        pools_[size_class] = std::make_unique<SlabPool>(SlotSize(size_class));
+    }
+    return pools_[size_class].get();
+}
+
+void* Arena::Allocate(uint8_t size_class) {
+    return Pool(size_class)->Allocate();
+}
+
+void* Arena::AllocateRun(uint8_t size_class, size_t max_count, size_t* count) {
+    return Pool(size_class)->AllocateRun(max_count, count);
+}
+
+void Arena::Free(void* ptr, uint8_t size_class) {
+    pools_[size_class]->Free(ptr);
+}
+
+void Arena::Absorb(Arena* other) {
+    for (size_t i = 0; i < pools_.size(); ++i) {
+        if (!other->pools_[i]) {
+            continue;
+        }
+        if (pools_[i]) {
+            pools_[i]->Absorb(other->pools_[i].get());
+        } else {
+            pools_[i] = std::move(other->pools_[i]);
+        }
+    }
+}
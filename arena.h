@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// Slab pool: hands out equally sized slots carved from large slabs.
+/// Freed slots go to an intrusive free list and are reused before the bump pointer moves on.
+
+class SlabPool {
+public:
+    explicit SlabPool(size_t slot_size);
+    SlabPool(const SlabPool& other) = delete;
+    ~SlabPool();
+
+    void* Allocate() {
+        if (free_list_) {
+            FreeSlot* slot = free_list_;
+            free_list_ = slot->next;
+            return slot;
+        }
+        if (bump_ == end_) {
+            Grow();
+        }
+        void* slot = bump_;
+        bump_ += slot_size_;
+        return slot;
+    }
+    // Returns *count consecutive slots, 1 <= *count <= max_count. Runs are cut from the bump
+    // region while it lasts, then freed slots are handed out one by one before the pool grows.
+    void* AllocateRun(size_t max_count, size_t* count);
+    void Free(void* ptr) {
+        FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+        slot->next = free_list_;
+        free_list_ = slot;
+    }
+    // Takes over the slabs of a pool of the same slot size, the slots other has not handed out
+    // are free in this pool then. Leaves other empty.
+    void Absorb(SlabPool* other);
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    void Grow();
+
+    size_t slot_size_;
+    FreeSlot* free_list_;
+    char* bump_;
+    char* end_;
+    std::vector<char*> slabs_;
+};
+
+/// Segregated size-class arena.
+/// Every size class has its own slab pool, so Cell, Number, Boolean, Symbol and Scope objects
+/// end up in separate slabs. Sizes above kMaxPooledSize go to the global operator new.
+
+class Arena {
+public:
+    static constexpr size_t kGranularity = 16;
+    static constexpr size_t kMaxPooledSize = 256;
+    static constexpr uint8_t kUnpooled = 0xff;
+
+    Arena() = default;
+    Arena(const Arena& other) = delete;
+
+    static uint8_t SizeClass(size_t size) {
+        if (size > kMaxPooledSize) {
+            return kUnpooled;
+        }
+        return static_cast<uint8_t>((size + kGranularity - 1) / kGranularity - 1);
+    }
+
+    static size_t SlotSize(uint8_t size_class) {
+        return (size_class + 1) * kGranularity;
+    }
+
+    void* Allocate(uint8_t size_class);
+    // See SlabPool::AllocateRun.
+    void* AllocateRun(uint8_t size_class, size_t max_count, size_t* count);
+    void Free(void* ptr, uint8_t size_class);
+    // Takes over the memory of other, see SlabPool::Absorb.
+    void Absorb(Arena* other);
+
+private:
+    SlabPool* Pool(uint8_t size_class);
+
+    std::array<std::unique_ptr<SlabPool>, kMaxPooledSize / kGranularity> pools_;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+/// Benchmarks
+/// Every case registers itself with a static BenchCase and prints its own results, one line per
+/// measurement. scheme_bench runs the cases named on its command line, or all of them.
+
+class BenchCase {
+public:
+    using Function = void (*)();
+
+    BenchCase(const char* name, Function run);
+};
+
+// Prints "case: what value unit".
+void Report(const std::string& what, double value, const char* unit);
+
+// Wall time of f in milliseconds.
+template <class F>
+double TimeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
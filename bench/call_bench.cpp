@@ -0,0 +1,42 @@
+#include "bench/bench.h"
+#include "scheme.h"
+
+#include <numeric>
+
+namespace {
+
+constexpr int kCalls = 500000;
+
+uint64_t Allocations(const Interpreter& interpreter) {
+    auto allocations = interpreter.GetGcStats().allocations;
+    return std::accumulate(allocations.begin(), allocations.end(), uint64_t{0});
+}
+
+// Reports the time of a loop of kCalls iterations and the heap objects made per iteration.
+void Run(Interpreter* interpreter, const std::string& what, const std::string& program) {
+    uint64_t before = Allocations(*interpreter);
+    Report(what, TimeMs([&] { interpreter->Run(program); }), "ms");
+    Report(what + " allocations per call",
+           static_cast<double>(Allocations(*interpreter) - before) / kCalls, "objects");
+}
+
+void Measure(const char* name, Interpreter::Engine engine) {
+    Interpreter interpreter(engine);
+    interpreter.Run("(define (add3 a b c) (+ a b c))");
+    interpreter.Run(
+        "(define (loop i acc) (if (= i 0) acc (loop (- i 1) (add3 acc i (* i 2)))))");
+    interpreter.Run("(define (sum i acc) (if (= i 0) acc (sum (- i 1) (+ acc i 1 2 3 4 5))))");
+    std::string calls = std::to_string(kCalls);
+    Run(&interpreter, std::string(name) + " 3-argument calls 500k", "(loop " + calls + " 0)");
+    Run(&interpreter, std::string(name) + " 7-argument + 500k", "(sum " + calls + " 0)");
+}
+
+// Argument passing to closures and builtins.
+void CallBench() {
+    Measure("tree walker", Interpreter::Engine::TREE_WALKER);
+    Measure("bytecode", Interpreter::Engine::BYTECODE);
+}
+
+BenchCase call("call", CallBench);
+
+}  // namespace
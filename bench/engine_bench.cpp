@@ -0,0 +1,32 @@
+#include "bench/bench.h"
+#include "scheme.h"
+
+namespace {
+
+void Measure(const char* name, Interpreter::Engine engine) {
+    Interpreter interpreter(engine);
+    interpreter.Run("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    interpreter.Run("(define (loop i acc) (if (= i 0) acc (loop (- i 1) (+ acc i))))");
+    interpreter.Run("(define (build i acc) (if (= i 0) acc (build (- i 1) (cons i acc))))");
+    interpreter.Run("(define (make-adder n) (lambda (x) (+ x n)))");
+    interpreter.Run(
+        "(define (closures i acc) (if (= i 0) acc (closures (- i 1) ((make-adder i) acc))))");
+    Report(std::string(name) + " fib 25", TimeMs([&] { interpreter.Run("(fib 25)"); }), "ms");
+    Report(std::string(name) + " loop 1M", TimeMs([&] { interpreter.Run("(loop 1000000 0)"); }),
+           "ms");
+    std::string map = "(car (map (lambda (x) (* x 2)) (build 100000 '())))";
+    Report(std::string(name) + " list build and map 100k",
+           TimeMs([&] { interpreter.Run(map); }), "ms");
+    Report(std::string(name) + " closures 200k",
+           TimeMs([&] { interpreter.Run("(closures 200000 0)"); }), "ms");
+}
+
+// The bytecode VM against the tree walker on calls, tail calls, lists and closures.
+void EngineBench() {
+    Measure("tree walker", Interpreter::Engine::TREE_WALKER);
+    Measure("bytecode", Interpreter::Engine::BYTECODE);
+}
+
+BenchCase engine("engine", EngineBench);
+
+}  // namespace
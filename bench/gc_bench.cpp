@@ -0,0 +1,29 @@
+#include "bench/bench.h"
+#include "object.h"
+
+namespace {
+
+constexpr size_t kListLength = 1'000'000;
+
+// Allocation throughput and marking of a long list, which used to overflow the stack.
+void GcBench() {
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope root;
+    Object* list = nullptr;
+    double build = TimeMs([&] {
+        for (size_t i = 0; i < kListLength; ++i) {
+            list = heap.Make<Cell>(MakeNumber(i), list);
+        }
+    });
+    Report("allocation", kListLength / build / 1000, "Mcells/s");
+    root.Define(Intern("list"), list);
+    Report("collect 1M-cell list", TimeMs([&] { heap.CleanUpFull(&root); }), "ms");
+    Report("collect 1M old cells", TimeMs([&] { heap.CleanUpFull(&root); }), "ms");
+    root.Define(Intern("list"), nullptr);
+    Report("free 1M cells", TimeMs([&] { heap.CleanUpFull(&root); }), "ms");
+}
+
+BenchCase gc("gc", GcBench);
+
+}  // namespace
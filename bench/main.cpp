@@ -0,0 +1,45 @@
+#include "bench/bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+namespace {
+
+std::map<std::string, BenchCase::Function>& Cases() {
+    static std::map<std::string, BenchCase::Function> cases;
+    return cases;
+}
+
+const char* current_case = "";
+
+}  // namespace
+
+BenchCase::BenchCase(const char* name, Function run) {
+    Cases().emplace(name, run);
+}
+
+void Report(const std::string& what, double value, const char* unit) {
+    std::printf("%s: %s %.3f %s\n", current_case, what.c_str(), value, unit);
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--list") == 0) {
+        for (const auto& [name, run] : Cases()) {
+            std::printf("%s\n", name.c_str());
+        }
+        return 0;
+    }
+    for (const auto& [name, run] : Cases()) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || name == argv[i];
+        }
+        if (selected) {
+            current_case = name.c_str();
+            run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "bench/bench.h"
+#include "object.h"
+#include "parser.h"
+
+namespace {
+
+constexpr int kElements = 1'000'000;
+constexpr int kDepth = 100'000;
+
+void Measure(const char* name, const std::string& input) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    Tokenizer tokenizer(input);
+    Report(name, TimeMs([&] { Read(&tokenizer); }), "ms");
+}
+
+// Reading of a long flat list and of deeply nested lists, which a recursive reader can not
+// read with the default stack.
+void ParserBench() {
+    std::string flat = "(";
+    for (int i = 0; i < kElements; ++i) {
+        flat += "1 ";
+    }
+    flat += ")";
+    Measure("flat 1M-element list", flat);
+    Measure("100k nested lists", std::string(kDepth, '(') + std::string(kDepth, ')'));
+    std::string mixed;
+    for (int i = 0; i < kDepth; ++i) {
+        mixed += "(a 1 ";
+    }
+    mixed += std::string(kDepth, ')');
+    Measure("100k nested lists with elements", mixed);
+}
+
+BenchCase parser("parser", ParserBench);
+
+}  // namespace
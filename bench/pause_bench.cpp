@@ -0,0 +1,37 @@
+#include "bench/bench.h"
+#include "scheme.h"
+
+#include <algorithm>
+
+namespace {
+
+// Longest collection pause with a large live heap, collected at once and incrementally.
+void PauseBench() {
+    for (int budget : {0, 100, 500}) {
+        Interpreter interpreter;
+        interpreter.SetGcPauseBudget(std::chrono::microseconds(budget));
+        interpreter.Run("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))");
+        for (int i = 0; i < 40; ++i) {
+            interpreter.Run("(define big" + std::to_string(i) + " (range 0 10000))");
+        }
+        // Only the pauses of the steady state are of interest.
+        std::chrono::nanoseconds max_pause{0};
+        std::chrono::nanoseconds total_pause{0};
+        interpreter.SetGcCallback([&](const HeapStats& stats) {
+            max_pause = std::max(max_pause, stats.last_pause);
+            total_pause += stats.last_pause;
+        });
+        for (int i = 0; i < 2000; ++i) {
+            interpreter.Run("(define keep" + std::to_string(i % 50) + " (range 0 2000))");
+        }
+        std::string name = "budget " + std::to_string(budget) + "us";
+        Report(name + " max pause", std::chrono::duration<double, std::milli>(max_pause).count(),
+               "ms");
+        Report(name + " total pause",
+               std::chrono::duration<double, std::milli>(total_pause).count(), "ms");
+    }
+}
+
+BenchCase pause("pause", PauseBench);
+
+}  // namespace
@@ -0,0 +1,30 @@
+#include "bench/bench.h"
+#include "interpreter_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int kPrograms = 256;
+
+// Throughput of independent programs with a growing number of threads.
+void PoolBench() {
+    Interpreter source;
+    source.Run("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    auto prelude = source.Snapshot();
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        InterpreterPool pool(threads, prelude);
+        std::vector<std::string> programs(kPrograms, "(fib 18)");
+        double ms = TimeMs([&] {
+            for (auto& result : pool.Submit(std::move(programs))) {
+                result.get();
+            }
+        });
+        Report(std::to_string(threads) + " threads", kPrograms / ms * 1000, "programs/s");
+    }
+}
+
+BenchCase pool("pool", PoolBench);
+
+}  // namespace
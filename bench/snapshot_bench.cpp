@@ -0,0 +1,64 @@
+#include "bench/bench.h"
+#include "scheme.h"
+
+namespace {
+
+constexpr int kDefinitions = 200;
+constexpr int kClones = 2000;
+// Prelude sizes for the clone cost, which loads the whole image and so grows with the prelude.
+constexpr int kCloneDefinitions[] = {50, 200, 800};
+
+// Two defines per definition.
+std::string MakePrelude(int definitions) {
+    std::string prelude;
+    for (int i = 0; i < definitions; ++i) {
+        std::string index = std::to_string(i);
+        prelude += "(define value-" + index + " '(" + index + " 2 3))\n";
+        prelude += "(define (function-" + index + " x) (+ x (car value-" + index + ")))\n";
+    }
+    return prelude;
+}
+
+// The cost of a clone against the prelude size, and starting interpreters from a snapshot
+// against evaluating the prelude in each of them.
+void SnapshotBench() {
+    for (int definitions : kCloneDefinitions) {
+        Interpreter source;
+        source.Run(std::string_view(MakePrelude(definitions)), [](const std::string&) {});
+        auto prelude = source.Snapshot();
+        int clones = kClones * kDefinitions / definitions;
+        double clone = TimeMs([&] {
+            for (int i = 0; i < clones; ++i) {
+                Interpreter interpreter(prelude);
+                interpreter.Run("(function-7 1)");
+            }
+        });
+        std::string size = std::to_string(definitions) + " definitions";
+        Report("clone and call, " + size, clone * 1000 / clones, "us");
+        Report("clone per definition, " + size, clone * 1e6 / clones / definitions, "ns");
+    }
+    std::string program = MakePrelude(kDefinitions);
+    Interpreter source;
+    source.Run(std::string_view(program), [](const std::string&) {});
+    std::shared_ptr<const Prelude> prelude;
+    Report("snapshot", TimeMs([&] { prelude = source.Snapshot(); }), "ms");
+    double clone = TimeMs([&] {
+        for (int i = 0; i < kClones; ++i) {
+            Interpreter interpreter(prelude);
+            interpreter.Run("(function-7 1)");
+        }
+    });
+    Report("clone and call", clone * 1000 / kClones, "us");
+    double fresh = TimeMs([&] {
+        for (int i = 0; i < kClones / 10; ++i) {
+            Interpreter interpreter;
+            interpreter.Run(std::string_view(program), [](const std::string&) {});
+            interpreter.Run("(function-7 1)");
+        }
+    });
+    Report("evaluate prelude and call", fresh * 10000 / kClones, "us");
+}
+
+BenchCase snapshot("snapshot", SnapshotBench);
+
+}  // namespace
@@ -0,0 +1,52 @@
+#include "bench/bench.h"
+#include "tokenizer.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr int kLines = 200'000;
+
+std::string MakeProgram() {
+    std::string program;
+    for (int i = 0; i < kLines; ++i) {
+        program += "(define (some-long-function-name-" + std::to_string(i) +
+                   " argument) (+ argument 1234567 #t))\n";
+    }
+    return program;
+}
+
+size_t CountTokens(Tokenizer* tokenizer) {
+    size_t count = 0;
+    while (!tokenizer->IsEnd()) {
+        tokenizer->GetToken();
+        tokenizer->Next();
+        ++count;
+    }
+    return count;
+}
+
+void Measure(const std::string& name, const std::string& program, Tokenizer* tokenizer) {
+    double ms = TimeMs([&] { CountTokens(tokenizer); });
+    Report(name, program.size() / ms / 1000, "MB/s");
+}
+
+// Scanning of a buffer with every scanner the CPU supports, and of a stream.
+void TokenizerBench() {
+    std::string program = MakeProgram();
+    for (auto [kind, name] : {std::pair{ScannerKind::SCALAR, "scalar buffer"},
+                              std::pair{ScannerKind::SSE2, "sse2 buffer"},
+                              std::pair{ScannerKind::AVX2, "avx2 buffer"}}) {
+        if (const Scanner* scanner = GetScanner(kind)) {
+            Tokenizer tokenizer(program, *scanner);
+            Measure(name, program, &tokenizer);
+        }
+    }
+    std::istringstream in(program);
+    Tokenizer tokenizer(&in);
+    Measure("stream", program, &tokenizer);
+}
+
+BenchCase tokenizer("tokenizer", TokenizerBench);
+
+}  // namespace
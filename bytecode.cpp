@@ -0,0 +1,418 @@
+#include "bytecode.h"
+#include "list_helper.h"
+#include "resolver.h"
+
+namespace {
+
+using Binding = LexicalEnv::Binding;
+
+enum class Form { CALL, QUOTE, IF, DEFINE, SET, LAMBDA, AND, OR, INTERPRET };
+
+// Arguments of a form as the tree walker sees them, false if they are not a list.
+bool Arguments(Object* expr, std::vector<Object*>* args) {
+    Object* rest = As<Cell>(expr)->GetSecond();
+    if (rest && !Is<Cell>(rest)) {
+        return false;
+    }
+    *args = ObjectToList(rest);
+    return true;
+}
+
+bool AllSymbols(const std::vector<Object*>& list, size_t from = 0) {
+    for (size_t i = from; i < list.size(); ++i) {
+        if (!Is<Symbol>(list[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SelfEvaluating(Object* expr) {
+    return IsImmediate(expr) || Is<Number>(expr) || Is<Boolean>(expr);
+}
+
+class Compiler {
+public:
+    explicit Compiler(Scope* scope) : scope_(scope) {
+    }
+
+    CodeBlock* CompileTop(Object* expr) {
+        CodeBlock* block = Hp().Make<CodeBlock>();
+        CompileExpr(block, expr, LexicalEnv(scope_), false);
+        block->Emit(OpCode::RETURN);
+        return block;
+    }
+
+private:
+    // Special forms are recognized by the global value of the head symbol at compile time.
+    Form Classify(Object* head, const LexicalEnv& env) const {
+        if (!Is<Symbol>(head) || env.Lookup(As<Symbol>(head)) != Binding::GLOBAL) {
+            return Form::CALL;
+        }
+        Object* value = scope_->Find(As<Symbol>(head));
+        if (!Is<FunctionalObject>(value) || Is<Procedure>(value)) {
+            return Form::CALL;
+        }
+        if (Is<QuoteFunctor>(value)) {
+            return Form::QUOTE;
+        }
+        if (Is<IfOperator>(value)) {
+            return Form::IF;
+        }
+        if (Is<DefineOperator>(value)) {
+            return Form::DEFINE;
+        }
+        if (Is<SetOperator>(value)) {
+            return Form::SET;
+        }
+        if (Is<LambdaMaker>(value)) {
+            return Form::LAMBDA;
+        }
+        if (Is<BooleanFunctor>(value)) {
+            return As<BooleanFunctor>(value)->GetStopValue() ? Form::OR : Form::AND;
+        }
+        return Form::INTERPRET;
+    }
+
+    void CompileExpr(CodeBlock* block, Object* expr, const LexicalEnv& env, bool tail) {
+        if (Is<Symbol>(expr)) {
+            CompileSymbol(block, As<Symbol>(expr), env);
+            return;
+        }
+        if (SelfEvaluating(expr)) {
+            block->Emit(OpCode::CONST, block->AddConstant(expr));
+            return;
+        }
+        if (!Is<Cell>(expr)) {
+            Interpret(block, expr);
+            return;
+        }
+        std::vector<Object*> args;
+        if (!Arguments(expr, &args)) {
+            Interpret(block, expr);
+            return;
+        }
+        Object* head = As<Cell>(expr)->GetFirst();
+        bool compiled = true;
+        switch (Classify(head, env)) {
+            case Form::CALL:
+                compiled = CompileCall(block, head, args, env, tail);
+                break;
+            case Form::QUOTE:
+                compiled = CompileQuote(block, args);
+                break;
+            case Form::IF:
+                compiled = CompileIf(block, args, env, tail);
+                break;
+            case Form::DEFINE:
+                compiled = CompileDefine(block, args, env);
+                break;
+            case Form::SET:
+                compiled = CompileSet(block, args, env);
+                break;
+            case Form::LAMBDA:
+                compiled = CompileLambda(block, args, env);
+                break;
+            case Form::AND:
+                CompileBoolean(block, args, env, tail, OpCode::AND_JUMP, true);
+                break;
+            case Form::OR:
+                CompileBoolean(block, args, env, tail, OpCode::OR_JUMP, false);
+                break;
+            case Form::INTERPRET:
+                compiled = false;
+                break;
+        }
+        if (!compiled) {
+            Interpret(block, expr);
+        }
+    }
+
+    void Interpret(CodeBlock* block, Object* expr) {
+        block->Emit(OpCode::INTERPRET, block->AddConstant(expr));
+    }
+
+    void CompileSymbol(CodeBlock* block, Symbol* symbol, const LexicalEnv& env) {
+        size_t depth;
+        size_t slot;
+        if (env.Lookup(symbol, &depth, &slot) == Binding::LOCAL) {
+            block->Emit(OpCode::LOCAL, depth, slot);
+        } else {
+            block->Emit(OpCode::GLOBAL, block->AddConstant(symbol));
+        }
+    }
+
+    bool CompileCall(CodeBlock* block, Object* head, const std::vector<Object*>& args,
+                     const LexicalEnv& env, bool tail) {
+        // An empty head fails only once the call is evaluated, as in the tree walker.
+        if (!head) {
+            return false;
+        }
+        CompileExpr(block, head, env, false);
+        for (Object* arg : args) {
+            CompileExpr(block, arg, env, false);
+        }
+        block->Emit(tail ? OpCode::TAIL_CALL : OpCode::CALL, args.size());
+        return true;
+    }
+
+    bool CompileQuote(CodeBlock* block, const std::vector<Object*>& args) {
+        if (args.size() != 1) {
+            return false;
+        }
+        block->Emit(OpCode::CONST, block->AddConstant(args[0]));
+        return true;
+    }
+
+    bool CompileIf(CodeBlock* block, const std::vector<Object*>& args, const LexicalEnv& env,
+                   bool tail) {
+        if (args.size() != 2 && args.size() != 3) {
+            return false;
+        }
+        CompileExpr(block, args[0], env, false);
+        size_t to_else = block->Emit(OpCode::JUMP_IF_FALSE);
+        CompileExpr(block, args[1], env, tail);
+        size_t to_end = block->Emit(OpCode::JUMP);
+        block->PatchJump(to_else);
+        if (args.size() == 3) {
+            CompileExpr(block, args[2], env, tail);
+        } else {
+            block->Emit(OpCode::CONST, block->AddConstant(nullptr));
+        }
+        block->PatchJump(to_end);
+        return true;
+    }
+
+    bool CompileDefine(CodeBlock* block, const std::vector<Object*>& args,
+                       const LexicalEnv& env) {
+        if (args.size() == 2 && Is<Symbol>(args[0])) {
+            CompileExpr(block, args[1], env, false);
+            block->Emit(OpCode::DEFINE, block->AddConstant(args[0]));
+            return true;
+        }
+        if (args.size() < 2 || !Is<Cell>(args[0])) {
+            return false;
+        }
+        std::vector<Object*> signature = ObjectToList(args[0]);
+        if (!AllSymbols(signature)) {
+            return false;
+        }
+        std::vector<Object*> params(signature.begin() + 1, signature.end());
+        std::vector<Object*> body(args.begin() + 1, args.end());
+        EmitClosure(block, params, body, env);
+        block->Emit(OpCode::DEFINE, block->AddConstant(signature[0]));
+        block->Emit(OpCode::POP);
+        block->Emit(OpCode::CONST, block->AddConstant(nullptr));
+        return true;
+    }
+
+    bool CompileSet(CodeBlock* block, const std::vector<Object*>& args, const LexicalEnv& env) {
+        if (args.size() != 2 || !Is<Symbol>(args[0])) {
+            return false;
+        }
+        CompileExpr(block, args[1], env, false);
+        size_t depth;
+        size_t slot;
+        if (env.Lookup(As<Symbol>(args[0]), &depth, &slot) == Binding::LOCAL) {
+            block->Emit(OpCode::SET_LOCAL, depth, slot);
+        } else {
+            block->Emit(OpCode::SET_GLOBAL, block->AddConstant(args[0]));
+        }
+        return true;
+    }
+
+    bool CompileLambda(CodeBlock* block, const std::vector<Object*>& args,
+                       const LexicalEnv& env) {
+        if (args.size() <= 1 || (args[0] && !Is<Cell>(args[0]))) {
+            return false;
+        }
+        std::vector<Object*> params = ObjectToList(args[0]);
+        if (!AllSymbols(params)) {
+            return false;
+        }
+        std::vector<Object*> body(args.begin() + 1, args.end());
+        EmitClosure(block, params, body, env);
+        return true;
+    }
+
+    void CompileBoolean(CodeBlock* block, const std::vector<Object*>& args,
+                        const LexicalEnv& env, bool tail, OpCode jump, bool empty_value) {
+        if (args.empty()) {
+            block->Emit(OpCode::CONST, block->AddConstant(MakeBoolean(empty_value)));
+            return;
+        }
+        std::vector<size_t> to_end;
+        for (size_t i = 0; i + 1 < args.size(); ++i) {
+            CompileExpr(block, args[i], env, false);
+            to_end.push_back(block->Emit(jump));
+        }
+        CompileExpr(block, args.back(), env, tail);
+        for (size_t position : to_end) {
+            block->PatchJump(position);
+        }
+    }
+
+    void EmitClosure(CodeBlock* block, const std::vector<Object*>& params,
+                     const std::vector<Object*>& body, const LexicalEnv& env) {
+        std::vector<const Symbol*> names;
+        names.reserve(params.size());
+        for (Object* param : params) {
+            names.push_back(As<Symbol>(param));
+        }
+        auto layout = MakeFrameLayout(names, body);
+        CodeBlock* lambda = Hp().Make<CodeBlock>(layout);
+        LexicalEnv inner = env.Push(layout.get());
+        for (size_t i = 0; i < body.size(); ++i) {
+            bool last = i + 1 == body.size();
+            CompileExpr(lambda, body[i], inner, last);
+            if (!last) {
+                lambda->Emit(OpCode::POP);
+            }
+        }
+        lambda->Emit(OpCode::RETURN);
+        block->Emit(OpCode::CLOSURE, block->AddConstant(lambda));
+    }
+
+    Scope* scope_;
+};
+
+struct MachineFrame {
+    CodeBlock* code;
+    size_t pc;
+    Scope* scope;
+};
+
+Object* Run(CodeBlock* code, Scope* scope) {
+    std::vector<Object*> stack;
+    std::vector<MachineFrame> frames{{code, 0, scope}};
+    while (true) {
+        MachineFrame& frame = frames.back();
+        const Instruction& instruction = frame.code->GetCode()[frame.pc++];
+        switch (instruction.op) {
+            case OpCode::CONST:
+                stack.push_back(frame.code->GetConstant(instruction.a));
+                break;
+            case OpCode::LOCAL:
+                stack.push_back(frame.scope->Frame(instruction.a)->GetSlot(instruction.b));
+                break;
+            case OpCode::GLOBAL: {
+                Symbol* name = As<Symbol>(frame.code->GetConstant(instruction.a));
+                Object** place = frame.scope->FindPlace(name);
+                if (!place) {
+                    throw NameError("can not eval symbol: no such name " + name->GetName());
+                }
+                stack.push_back(*place);
+                break;
+            }
+            case OpCode::SET_LOCAL:
+                frame.scope->Frame(instruction.a)->SetSlot(instruction.b, stack.back());
+                break;
+            case OpCode::SET_GLOBAL:
+                frame.scope->Set(As<Symbol>(frame.code->GetConstant(instruction.a)),
+                                 stack.back());
+                break;
+            case OpCode::DEFINE:
+                frame.scope->Define(As<Symbol>(frame.code->GetConstant(instruction.a)),
+                                    stack.back());
+                break;
+            case OpCode::POP:
+                stack.pop_back();
+                break;
+            case OpCode::JUMP:
+                frame.pc = instruction.a;
+                break;
+            case OpCode::JUMP_IF_FALSE: {
+                Object* condition = stack.back();
+                stack.pop_back();
+                if (!Is<Boolean>(condition)) {
+                    throw RuntimeError("condition argument must be boolean");
+                }
+                if (!As<Boolean>(condition)->GetValue()) {
+                    frame.pc = instruction.a;
+                }
+                break;
+            }
+            case OpCode::AND_JUMP:
+            case OpCode::OR_JUMP: {
+                Object* value = stack.back();
+                bool truth = !Is<Boolean>(value) || As<Boolean>(value)->GetValue();
+                if (truth == (instruction.op == OpCode::OR_JUMP)) {
+                    frame.pc = instruction.a;
+                } else {
+                    stack.pop_back();
+                }
+                break;
+            }
+            case OpCode::CLOSURE:
+                stack.push_back(Hp().Make<VmClosure>(
+                    As<CodeBlock>(frame.code->GetConstant(instruction.a)), frame.scope));
+                break;
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL: {
+                size_t count = instruction.a;
+                Object** args = stack.data() + stack.size() - count;
+                Object* function = args[-1];
+                if (Is<VmClosure>(function)) {
+                    VmClosure* closure = As<VmClosure>(function);
+                    Scope* callee = closure->MakeFrame(args, count);
+                    stack.resize(stack.size() - count - 1);
+                    if (instruction.op == OpCode::TAIL_CALL) {
+                        frame = MachineFrame{closure->GetCode(), 0, callee};
+                    } else {
+                        frames.push_back(MachineFrame{closure->GetCode(), 0, callee});
+                    }
+                    break;
+                }
+                if (!Is<Procedure>(function)) {
+                    throw RuntimeError("cant evaluate cell");
+                }
+                // Nothing is pushed onto this stack before Apply returns, args stay valid.
+                Object* result = As<Procedure>(function)->Apply(ArgSpan(args, count));
+                stack.resize(stack.size() - count - 1);
+                stack.push_back(result);
+                if (instruction.op == OpCode::CALL) {
+                    break;
+                }
+                [[fallthrough]];
+            }
+            case OpCode::RETURN:
+                frames.pop_back();
+                if (frames.empty()) {
+                    return stack.back();
+                }
+                break;
+            case OpCode::INTERPRET:
+                stack.push_back(Evaluate(frame.code->GetConstant(instruction.a), frame.scope));
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+Scope* VmClosure::MakeFrame(Object* const* args, size_t count) const {
+    const auto& layout = code_->GetLayout();
+    if (count < layout->slots.size()) {
+        throw RuntimeError("too few arguments for lambda calculation");
+    }
+    if (layout->slots.size() < count) {
+        throw RuntimeError("too much arguments for lambda calculation");
+    }
+    Scope* frame = Hp().Make<Scope>(env_, layout);
+    for (size_t i = 0; i < count; ++i) {
+        frame->SetSlot(i, args[i]);
+    }
+    return frame;
+}
+
+Object* VmClosure::Apply(ArgSpan list) const {
+    return Run(code_, MakeFrame(list.data(), list.size()));
+}
+
+CodeBlock* Compile(Object* expr, Scope* scope) {
+    return Compiler(scope).CompileTop(expr);
+}
+
+Object* Execute(CodeBlock* code, Scope* scope) {
+    return Run(code, scope);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "functional_object.h"
+
+/// Bytecode engine
+/// An alternative to the tree walker: an expression is compiled once into a flat instruction
+/// sequence which a stack machine executes. Frames are ordinary Scope objects with a slot
+/// layout, so compiled code and tree-walked code can call each other freely.
+
+enum class OpCode : uint8_t {
+    CONST,          // push constants[a]
+    LOCAL,          // push slot b of the frame a levels up
+    GLOBAL,         // push the value of symbol constants[a], looked up by name
+    SET_LOCAL,      // store the top into slot b of the frame a levels up, keep it
+    SET_GLOBAL,     // set! symbol constants[a] to the top, keep it
+    DEFINE,         // define symbol constants[a] in the current frame as the top, keep it
+    POP,            // drop the top
+    JUMP,           // continue at a
+    JUMP_IF_FALSE,  // pop a boolean condition, continue at a if it is #f
+    AND_JUMP,       // continue at a keeping the top if it is #f, pop it otherwise
+    OR_JUMP,        // continue at a keeping the top unless it is #f, pop it otherwise
+    CLOSURE,        // push a closure of the code block constants[a] over the current frame
+    CALL,           // call the procedure below a arguments
+    TAIL_CALL,      // same as CALL followed by RETURN, reusing the machine frame
+    RETURN,         // leave the current frame with the top as result
+    INTERPRET,      // evaluate constants[a] with the tree walker in the current frame
+};
+
+struct Instruction {
+    OpCode op;
+    uint32_t a = 0;
+    uint32_t b = 0;
+};
+
+// Compiled top-level expression or lambda body.
+class CodeBlock : public Object {
+public:
+    CodeBlock(std::shared_ptr<const FrameLayout> layout = nullptr)
+        : Object(TypeTag::CODE_BLOCK), layout_(std::move(layout)) {
+    }
+    Object* Eval(Object*) const override {
+        throw std::logic_error("Can not eval code block");
+    }
+    std::string Serialize() const override {
+        throw std::logic_error("Can not serialize code block");
+    }
+    Object* AllocateCopy() const override {
+        return nullptr;
+    }
+    void Trace(Tracer* tracer) const override {
+        for (Object* constant : constants_) {
+            tracer->Visit(constant);
+        }
+    }
+
+    // Layout of the frame the code runs in, nullptr for top-level code.
+    const std::shared_ptr<const FrameLayout>& GetLayout() const {
+        return layout_;
+    }
+    const std::vector<Instruction>& GetCode() const {
+        return code_;
+    }
+    Object* GetConstant(size_t index) const {
+        return constants_[index];
+    }
+    const std::vector<Object*>& GetConstants() const {
+        return constants_;
+    }
+
+    size_t Emit(OpCode op, uint32_t a = 0, uint32_t b = 0) {
+        code_.push_back(Instruction{op, a, b});
+        return code_.size() - 1;
+    }
+    // Makes the jump at position point to the next emitted instruction.
+    void PatchJump(size_t position) {
+        code_[position].a = code_.size();
+    }
+    uint32_t AddConstant(Object* constant) {
+        constants_.push_back(constant);
+        return constants_.size() - 1;
+    }
+
+private:
+    std::shared_ptr<const FrameLayout> layout_;
+    std::vector<Instruction> code_;
+    std::vector<Object*> constants_;
+};
+
+class VmClosure : public Procedure {
+public:
+    VmClosure(CodeBlock* code, Scope* env)
+        : Procedure(TypeTag::VM_CLOSURE), code_(code), env_(env) {
+        env_->MarkCaptured();
+    }
+    Object* Apply(ArgSpan) const override;
+    void Trace(Tracer* tracer) const override {
+        tracer->Visit(code_);
+        tracer->Visit(env_);
+    }
+
+    CodeBlock* GetCode() const {
+        return code_;
+    }
+    Scope* GetEnv() const {
+        return env_;
+    }
+    // Creates the call frame and fills the argument slots.
+    Scope* MakeFrame(Object* const* args, size_t count) const;
+
+private:
+    CodeBlock* code_;
+    Scope* env_;
+};
+
+template <>
+struct TypeTags<CodeBlock> : TagRange<TypeTag::CODE_BLOCK> {};
+template <>
+struct TypeTags<VmClosure> : TagRange<TypeTag::VM_CLOSURE> {};
+
+// Compiles expr to be run in scope. Never throws on malformed code: forms the compiler does not
+// understand are left to the tree walker, which reports the error when they are evaluated.
+CodeBlock* Compile(Object* expr, Scope* scope);
+
+Object* Execute(CodeBlock* code, Scope* scope);
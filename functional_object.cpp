@@ -1,8 +1,29 @@
 #include "functional_object.h"
 #include "list_helper.h"
+#include "parallel.h"
+#include "resolver.h"
 
-Object* FunctionalObject::Calc(Object* o, Object* scope) const {
-    return Calc(ObjectToList(o), scope);
+Object* Complete(Object* value, const TailCall& tail) {
+    return tail.scope ? Evaluate(tail.expr, tail.scope) : value;
+}
+
+Object* FunctionalObject::Calc(Object* args, Object* scope) const {
+    TailCall tail;
+    Object* ret = TailCalc(args, scope, &tail);
+    return Complete(ret, tail);
+}
+
+Object* FunctionalObject::TailCalc(Object* args, Object* scope, TailCall*) const {
+    return Calc(ObjectToList(args), scope);
+}
+
+Object* FunctionalObject::Calc(const std::vector<Object*>&, Object*) const {
+    throw std::logic_error("functional object does not take argument vectors");
+}
+
+Object* Procedure::TailCalc(Object* args, Object* scope, TailCall* tail) const {
+    EvaluatedArgs values(args, scope);
+    return TailApply(values.Get(), tail);
 }
 
 Object* QuoteFunctor::Calc(const std::vector<Object*>& list, Object*) const {
@@ -12,158 +33,171 @@ Object* QuoteFunctor::Calc(const std::vector<Object*>& list, Object*) const {
     return list[0];
 }
 
-Object* BooleanFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* BooleanFunctor::TailCalc(Object* args, Object* scope, TailCall* tail) const {
     bool ret = !stop_value_;
-    if (list.empty()) {
-        return Hp().Make<Boolean>(ret);
-    }
-    for (Object* cur : list) {
+    size_t size = 0;
+    Object* last = nullptr;
+    ForEachElement(args, [&](Object* cur) {
         if (!cur) {
             throw RuntimeError("list contains empty sublist");
         }
-        Object* cur_eval = cur->Eval(scope);
+        ++size;
+        last = cur;
+    });
+    if (size == 0) {
+        return MakeBoolean(ret);
+    }
+    Object* result = nullptr;
+    size_t index = 0;
+    ForEachElement(args, [&](Object* cur) {
+        if (result || ++index == size) {
+            return;
+        }
+        Object* cur_eval = Evaluate(cur, scope);
         bool converted_to_bool = !Is<Boolean>(cur_eval) || As<Boolean>(cur_eval)->GetValue();
         ret = functor_(ret, converted_to_bool);
         if (ret == stop_value_) {
-            return cur_eval;
+            result = cur_eval;
         }
+    });
+    if (result) {
+        return result;
     }
-    return list.back()->Eval(scope);
+    // The value of the last operand is the result whatever it is.
+    tail->expr = last;
+    tail->scope = As<Scope>(scope);
+    return nullptr;
 }
 
-Object* NumberFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
-    int64_t ret;
-    if (first_.has_value()) {
-        ret = first_.value();
-    } else if (list.empty()) {
+Object* NumberFunctor::Apply(ArgSpan list) const {
+    if (!first_.has_value() && list.empty()) {
         throw RuntimeError(
             "number functions without first defined value can not be computed by zero values");
     }
+    // The first argument replaces the first value, which is the result of no arguments.
+    int64_t ret = first_.value_or(0);
     bool first_value = true;
-    for (Object* cur : list) {
-        if (!cur) {
-            throw RuntimeError("list contains empty sublist");
-        }
-        Object* cur_eval = cur->Eval(scope);
+    for (Object* cur_eval : list) {
         if (!Is<Number>(cur_eval)) {
             throw RuntimeError("number function argument must be numbers");
         }
         if (first_value) {
-            ret = As<Number>(cur_eval)->GetValue();
+            ret = GetNumber(cur_eval);
             first_value = false;
         } else {
-            ret = functor_(ret, As<Number>(cur_eval)->GetValue());
+            ret = functor_(ret, GetNumber(cur_eval));
         }
     }
-    return Hp().Make<Number>(ret);
+    return MakeNumber(ret);
 }
 
-Object* BooleanNot::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* BooleanNot::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("not operator works with 1-element list only");
     }
-    Object* eval = list.back()->Eval(scope);
+    Object* eval = list.back();
     bool res = Is<Boolean>(eval) && !As<Boolean>(eval)->GetValue();
-    return Hp().Make<Boolean>(res);
+    return MakeBoolean(res);
 }
 
-Object* CompareFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
-    auto list_eval = EvalList<Number>(list, scope);
-    for (size_t i = 0; i + 1 < list_eval.size(); ++i) {
-        if (!functor_(list_eval[i]->GetValue(), list_eval[i + 1]->GetValue())) {
-            return Hp().Make<Boolean>(false);
+Object* CompareFunctor::Apply(ArgSpan list) const {
+    for (Object* cur_eval : list) {
+        if (!Is<Number>(cur_eval)) {
+            throw RuntimeError("cant evaluate list");
+        }
+    }
+    for (size_t i = 0; i + 1 < list.size(); ++i) {
+        if (!functor_(GetNumber(list[i]), GetNumber(list[i + 1]))) {
+            return MakeBoolean(false);
         }
     }
-    return Hp().Make<Boolean>(true);
+    return MakeBoolean(true);
 }
 
-Object* NumberAbs::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* NumberAbs::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("abs operator works with 1-element list only");
     }
-    Object* elem_eval = list.back()->Eval(scope);
+    Object* elem_eval = list.back();
     if (!Is<Number>(elem_eval)) {
         throw RuntimeError("abs operator works with numbers only");
     }
-    int64_t val = As<Number>(elem_eval)->GetValue();
-    return Hp().Make<Number>(val < 0 ? -val : val);
+    int64_t val = GetNumber(elem_eval);
+    return MakeNumber(val < 0 ? -val : val);
 }
 
-Object* CheckListFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* CheckListFunctor::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("check-type operators works with 1-element list only");
     }
-    Object* cur = list.back()->Eval(scope);
+    Object* cur = list.back();
     if (!cur) {
-        return Hp().Make<Boolean>(true);
+        return MakeBoolean(true);
     }
     while (true) {
         if (!Is<Cell>(cur)) {
-            return Hp().Make<Boolean>(false);
+            return MakeBoolean(false);
         }
         Object* next = As<Cell>(cur)->GetSecond();
         if (!next) {
-            return Hp().Make<Boolean>(true);
+            return MakeBoolean(true);
         }
         cur = next;
     }
     throw RuntimeError("check-list functor: unexpected behavior");
 }
-Object* CheckNullFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* CheckNullFunctor::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("check-type operator works with 1-element list only");
     }
-    return Hp().Make<Boolean>(!list.back()->Eval(scope));
+    return MakeBoolean(!list.back());
 }
-Object* ConsFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* ConsFunctor::Apply(ArgSpan list) const {
     if (list.size() != 2) {
         throw RuntimeError("cons function works with 1-element list only");
     }
-    Object* first_eval = list[0]->Eval(scope);
-    Object* second_eval = list.back()->Eval(scope);
-    return Hp().Make<Cell>(first_eval, second_eval);
+    return Hp().Make<Cell>(list[0], list.back());
 }
 
 Object* ListFunctor::Calc(const std::vector<Object*>& list, Object*) const {
     return ListToObject(list);
 }
 
-Object* CarFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* CarFunctor::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("car function works with 1-element list only");
     }
-    Object* first_eval = list.back()->Eval(scope);
+    Object* first_eval = list.back();
     if (!Is<Cell>(first_eval)) {
         throw RuntimeError("car function works with cells only");
     }
     return As<Cell>(first_eval)->GetFirst();
 }
 
-Object* CdrFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* CdrFunctor::Apply(ArgSpan list) const {
     if (list.size() != 1) {
         throw RuntimeError("cdr function works with 1-element list only");
     }
-    Object* first_eval = list.back()->Eval(scope);
+    Object* first_eval = list.back();
     if (!Is<Cell>(first_eval)) {
         throw RuntimeError("cdr function argument must be a cell");
     }
     return As<Cell>(first_eval)->GetSecond();
 }
 
-std::pair<std::vector<Object*>, int64_t> ListAbstractFunctor::Parse(
-    const std::vector<Object*>& list, Object* scope) const {
+std::pair<std::vector<Object*>, int64_t> ListAbstractFunctor::Parse(ArgSpan list) const {
     if (list.size() != 2) {
         throw RuntimeError("list- function works with 2-element list only");
     }
-    Object* first_eval = list[0]->Eval(scope);
-    Object* second_eval = list.back()->Eval(scope);
+    Object* first_eval = list[0];
+    Object* second_eval = list.back();
     if (!Is<Cell>(first_eval)) {
         throw RuntimeError("list- function first argument must be a cell");
     }
     if (!Is<Number>(second_eval)) {
         throw RuntimeError("list- function second argument must be a number");
     }
-    int64_t val = As<Number>(second_eval)->GetValue();
+    int64_t val = GetNumber(second_eval);
     if (val < 0) {
         throw RuntimeError("list- function second argument must be non-negative");
     }
@@ -171,17 +205,17 @@ std::pair<std::vector<Object*>, int64_t> ListAbstractFunctor::Parse(
     return std::make_pair(list_eval, val);
 }
 
-Object* ListRefFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
-    auto [list_eval, index] = Parse(list, scope);
-    if (list_eval.size() <= index) {
+Object* ListRefFunctor::Apply(ArgSpan list) const {
+    auto [list_eval, index] = Parse(list);
+    if (list_eval.size() <= static_cast<size_t>(index)) {
         throw RuntimeError("list-ref function second argument must be less than the list size");
     }
     return list_eval[index];
 }
 
-Object* ListTailFunctor::Calc(const std::vector<Object*>& list, Object* scope) const {
-    auto [list_eval, len] = Parse(list, scope);
-    if (list_eval.size() < len) {
+Object* ListTailFunctor::Apply(ArgSpan list) const {
+    auto [list_eval, len] = Parse(list);
+    if (list_eval.size() < static_cast<size_t>(len)) {
         throw RuntimeError(
             "list-tail function second argument must be less or equal than the list size");
     }
@@ -192,21 +226,200 @@ Object* ListTailFunctor::Calc(const std::vector<Object*>& list, Object* scope) c
     return ListToObject(cut_list);
 }
 
-Object* IfOperator::Calc(const std::vector<Object*>& list, Object* scope) const {
-    if (list.size() != 2 && list.size() != 3) {
+namespace {
+
+Procedure* GetProcedure(Object* obj, const char* name) {
+    if (!Is<Procedure>(obj)) {
+        throw RuntimeError(std::string(name) + " function first argument must be a procedure");
+    }
+    return As<Procedure>(obj);
+}
+
+// Walks a list cell by cell, without copying it into a vector.
+class ListCursor {
+public:
+    ListCursor(Object* list, const char* name) : cur_(list), name_(name) {
+    }
+
+    bool Done() const {
+        return !cur_;
+    }
+    Object* Next() {
+        if (!Is<Cell>(cur_)) {
+            throw RuntimeError(std::string(name_) + " function works with proper lists only");
+        }
+        Object* value = As<Cell>(cur_)->GetFirst();
+        cur_ = As<Cell>(cur_)->GetSecond();
+        return value;
+    }
+
+private:
+    Object* cur_;
+    const char* name_;
+};
+
+// Calls f on the elements of the lists in lockstep until the shortest one ends. The element
+// arguments of each call come first in args, followed by extra.
+template <class F>
+void ForEachRow(ArgSpan lists, size_t extra, const char* name, F&& f) {
+    if (lists.empty()) {
+        throw RuntimeError(std::string(name) + " function needs at least one list");
+    }
+    std::vector<ListCursor> cursors;
+    cursors.reserve(lists.size());
+    for (Object* list : lists) {
+        cursors.emplace_back(list, name);
+    }
+    std::vector<Object*> args(lists.size() + extra);
+    while (true) {
+        for (const ListCursor& cursor : cursors) {
+            if (cursor.Done()) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            args[i] = cursors[i].Next();
+        }
+        f(args);
+    }
+}
+
+bool IsTrue(Object* obj) {
+    return !Is<Boolean>(obj) || As<Boolean>(obj)->GetValue();
+}
+
+}  // namespace
+
+Object* MapFunctor::Apply(ArgSpan list) const {
+    if (list.empty()) {
+        throw RuntimeError("map function needs a procedure");
+    }
+    Procedure* f = GetProcedure(list[0], "map");
+    std::vector<Object*> results;
+    ForEachRow(list.subspan(1), 0, "map",
+               [&](const std::vector<Object*>& args) { results.push_back(f->Apply(args)); });
+    return Hp().MakeList(results.data(), results.size());
+}
+
+Object* ForEachFunctor::Apply(ArgSpan list) const {
+    if (list.empty()) {
+        throw RuntimeError("for-each function needs a procedure");
+    }
+    Procedure* f = GetProcedure(list[0], "for-each");
+    ForEachRow(list.subspan(1), 0, "for-each",
+               [&](const std::vector<Object*>& args) { f->Apply(args); });
+    return nullptr;
+}
+
+Object* FilterFunctor::Apply(ArgSpan list) const {
+    if (list.size() != 2) {
+        throw RuntimeError("filter function works with 2-element list only");
+    }
+    Procedure* f = GetProcedure(list[0], "filter");
+    std::vector<Object*> results;
+    ForEachRow(list.subspan(1), 0, "filter", [&](const std::vector<Object*>& args) {
+        if (IsTrue(f->Apply(args))) {
+            results.push_back(args[0]);
+        }
+    });
+    return Hp().MakeList(results.data(), results.size());
+}
+
+Object* FoldFunctor::Apply(ArgSpan list) const {
+    if (list.size() < 3) {
+        throw RuntimeError("fold function needs a procedure, an initial value and a list");
+    }
+    Procedure* f = GetProcedure(list[0], "fold");
+    Object* acc = list[1];
+    ForEachRow(list.subspan(2), 1, "fold", [&](std::vector<Object*>& args) {
+        args.back() = acc;
+        acc = f->Apply(args);
+    });
+    return acc;
+}
+
+Object* ParallelMapFunctor::Apply(ArgSpan list) const {
+    if (list.size() != 2) {
+        throw RuntimeError("par-map function works with 2-element list only");
+    }
+    Procedure* f = GetProcedure(list[0], "par-map");
+    // The chunks need random access to the elements.
+    std::vector<Object*> items;
+    for (ListCursor cursor(list[1], "par-map"); !cursor.Done();) {
+        items.push_back(cursor.Next());
+    }
+    std::vector<Object*> results(items.size());
+    ParallelFor(items.size(), [&](size_t i) {
+        Object* arg = items[i];
+        results[i] = f->Apply(ArgSpan(&arg, 1));
+    });
+    return Hp().MakeList(results.data(), results.size());
+}
+
+namespace {
+
+Object* MakeEntry(const char* name, int64_t value) {
+    return Hp().Make<Cell>(Intern(name), MakeNumber(value));
+}
+
+int64_t Microseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+}  // namespace
+
+Object* GcStatsFunctor::Apply(ArgSpan list) const {
+    if (!list.empty()) {
+        throw RuntimeError("gc-stats function takes no arguments");
+    }
+    HeapStats stats = Hp().GetStats();
+    std::vector<Object*> allocations;
+    for (size_t i = 0; i < HeapStats::kTypeCount; ++i) {
+        if (stats.allocations[i] != 0) {
+            allocations.push_back(
+                MakeEntry(TypeTagName(static_cast<TypeTag>(i)), stats.allocations[i]));
+        }
+    }
+    Object* entries[] = {
+        MakeEntry("minor-collections", stats.minor_collections),
+        MakeEntry("major-collections", stats.major_collections),
+        MakeEntry("bytes-allocated", stats.bytes_allocated),
+        MakeEntry("objects-freed", stats.objects_freed),
+        MakeEntry("young-collected", stats.young_collected),
+        MakeEntry("young-promoted", stats.young_promoted),
+        MakeEntry("last-pause", Microseconds(stats.last_pause)),
+        MakeEntry("max-pause", Microseconds(stats.max_pause)),
+        MakeEntry("total-pause", Microseconds(stats.total_pause)),
+        MakeEntry("mark-time", Microseconds(stats.mark_time)),
+        MakeEntry("sweep-time", Microseconds(stats.sweep_time)),
+        MakeEntry("young-objects", stats.young_objects),
+        MakeEntry("old-objects", stats.old_objects),
+        MakeEntry("live-after-major", stats.live_after_major),
+        Hp().Make<Cell>(Intern("allocations"),
+                        Hp().MakeList(allocations.data(), allocations.size())),
+    };
+    return Hp().MakeList(entries, std::size(entries));
+}
+
+Object* IfOperator::TailCalc(Object* args, Object* scope, TailCall* tail) const {
+    Object* list[3];
+    size_t size = UnpackList(args, list, 3);
+    if (size != 2 && size != 3) {
         throw SyntaxError("operator if needs two or three arguments");
     }
-    Object* condition_val = list[0]->Eval(scope);
+    Object* condition_val = Evaluate(list[0], scope);
     if (!Is<Boolean>(condition_val)) {
         throw RuntimeError("condition argument must be boolean");
     }
     if (As<Boolean>(condition_val)->GetValue()) {
-        return list[1]->Eval(scope);
-    } else if (!As<Boolean>(condition_val)->GetValue() && list.size() == 3) {
-        return list[2]->Eval(scope);
+        tail->expr = list[1];
+    } else if (size == 3) {
+        tail->expr = list[2];
     } else {
         return nullptr;
     }
+    tail->scope = As<Scope>(scope);
+    return nullptr;
 }
 
 Object* DefineOperator::Calc(const std::vector<Object*>& list, Object* scope) const {
@@ -236,7 +449,7 @@ Object* DefineOperator::DefineVariable(Object* var, Object* val, Object* scope)
     if (!Is<Scope>(scope)) {
         throw std::logic_error("operator define variable needs scope as third argument");
     }
-    As<Scope>(scope)->Define(As<Symbol>(var)->GetName(), val->Eval(scope));
+    As<Scope>(scope)->Define(As<Symbol>(var), Evaluate(val, scope));
     return As<Symbol>(var)->Eval(scope);
 }
 
@@ -257,11 +470,11 @@ Object* DefineOperator::DefineFunction(Object* cell, std::vector<Object*> instru
             throw SyntaxError("operator define function first argument contains non-symbol value");
         }
     }
-    std::string function_name = As<Symbol>(variables[0])->GetName();
-    std::vector<std::string> arg_names;
+    Symbol* function_name = As<Symbol>(variables[0]);
+    std::vector<const Symbol*> arg_names;
     arg_names.reserve(variables.size() - 1);
     for (size_t i = 1; i < variables.size(); ++i) {
-        arg_names.push_back(As<Symbol>(variables[i])->GetName());
+        arg_names.push_back(As<Symbol>(variables[i]));
     }
     Lambda* lambda = Hp().Make<Lambda>(arg_names, instructions, As<Scope>(scope));
     As<Scope>(scope)->Define(function_name, lambda);
@@ -275,11 +488,17 @@ Object* SetOperator::Calc(const std::vector<Object*>& list, Object* scope) const
     if (!Is<Scope>(scope)) {
         throw std::logic_error("operator set: scope needs to be scope");
     }
+    if (Is<LocalRef>(list[0])) {
+        LocalRef* ref = As<LocalRef>(list[0]);
+        Object* value = Evaluate(list[1], scope);
+        As<Scope>(scope)->Frame(ref->GetDepth())->SetSlot(ref->GetSlot(), value);
+        return value;
+    }
     if (!Is<Symbol>(list[0])) {
         throw RuntimeError("operator set first argument must be a symbol");
     }
-    As<Scope>(scope)->Set(As<Symbol>(list[0])->GetName(), list[1]->Eval(scope));
-    return list[0]->Eval(scope);
+    As<Scope>(scope)->Set(As<Symbol>(list[0]), Evaluate(list[1], scope));
+    return Evaluate(list[0], scope);
 }
 
 Object* LambdaMaker::Calc(const std::vector<Object*>& list, Object* scope) const {
@@ -290,13 +509,13 @@ Object* LambdaMaker::Calc(const std::vector<Object*>& list, Object* scope) const
         throw SyntaxError("the first argument of lambda must be a cell");
     }
     std::vector<Object*> lambda_args = ObjectToList(list[0]);
-    std::vector<std::string> lambda_arg_names;
+    std::vector<const Symbol*> lambda_arg_names;
     lambda_arg_names.reserve(lambda_args.size());
     for (Object* cur_arg : lambda_args) {
         if (!Is<Symbol>(cur_arg)) {
             throw SyntaxError("lambda args must be variables");
         }
-        lambda_arg_names.push_back(As<Symbol>(cur_arg)->GetName());
+        lambda_arg_names.push_back(As<Symbol>(cur_arg));
     }
     std::vector<Object*> lambda_instructions;
     for (size_t i = 1; i < list.size(); ++i) {
@@ -308,55 +527,86 @@ Object* LambdaMaker::Calc(const std::vector<Object*>& list, Object* scope) const
     return Hp().Make<Lambda>(lambda_arg_names, lambda_instructions, As<Scope>(scope));
 }
 
-Lambda::Lambda(const std::vector<std::string>& arg_names, std::vector<Object*> body,
+Lambda::Lambda(const std::vector<const Symbol*>& arg_names, std::vector<Object*> body,
                Scope* parent_scope)
-    : arg_names_(arg_names), body_(body), parent_scope_(parent_scope) {
+    : Procedure(TypeTag::LAMBDA),
+      layout_(MakeFrameLayout(arg_names, body)),
+      body_(ResolveBody(body, layout_.get(), parent_scope)),
+      parent_scope_(parent_scope) {
+    parent_scope_->MarkCaptured();
+}
+
+Lambda::Lambda(std::shared_ptr<const FrameLayout> layout, std::vector<Object*> body,
+               Scope* parent_scope)
+    : Procedure(TypeTag::LAMBDA),
+      layout_(std::move(layout)),
+      body_(std::move(body)),
+      parent_scope_(parent_scope) {
+    parent_scope_->MarkCaptured();
+}
+
+void Lambda::Trace(Tracer* tracer) const {
     for (Object* cur_instruction : body_) {
-        AddDep(cur_instruction);
+        tracer->Visit(cur_instruction);
     }
-    AddDep(parent_scope_);
+    tracer->Visit(parent_scope_);
 }
 
-Object* Lambda::Calc(const std::vector<Object*>& list, Object* outer_scope) const {
+Object* Lambda::Apply(ArgSpan list) const {
+    TailCall tail;
+    Object* ret = TailApply(list, &tail);
+    return Complete(ret, tail);
+}
+
+Object* Lambda::TailApply(ArgSpan list, TailCall* tail) const {
     if (body_.empty()) {
         throw std::logic_error("lambda body is empty at the moment of calculation");
     }
-    if (list.size() < arg_names_.size()) {
+    size_t arg_count = layout_->slots.size();
+    if (list.size() < arg_count) {
         throw RuntimeError("too few arguments for lambda calculation");
     }
-    if (arg_names_.size() < list.size()) {
+    if (arg_count < list.size()) {
         throw RuntimeError("too much arguments for lambda calculation");
     }
-    Scope* current_call_scope = Hp().Make<Scope>(parent_scope_);
-    for (size_t i = 0; i < arg_names_.size(); ++i) {
-        current_call_scope->Define(arg_names_[i], list[i]->Eval(outer_scope));
+    // A self tail call may run in the frame of the finished call, unless the arguments have just
+    // captured it.
+    Scope* current_call_scope = tail->spare;
+    if (current_call_scope && current_call_scope->GetLayout() == layout_.get() &&
+        !current_call_scope->Captured()) {
+        current_call_scope->Recycle();
+    } else {
+        current_call_scope = Hp().Make<Scope>(parent_scope_, layout_);
+    }
+    for (size_t i = 0; i < arg_count; ++i) {
+        current_call_scope->SetSlot(i, list[i]);
     }
     for (size_t i = 0; i + 1 < body_.size(); ++i) {
-        body_[i]->Eval(current_call_scope);
+        Evaluate(body_[i], current_call_scope);
     }
-    return body_.back()->Eval(current_call_scope);
+    tail->expr = body_.back();
+    tail->scope = current_call_scope;
+    return nullptr;
 }
 
-Object* SetCarOperator::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* SetCarOperator::Apply(ArgSpan list) const {
     if (list.size() != 2) {
         throw SyntaxError("set-car operator needs exactly 2 arguments");
     }
-    if (!Is<Cell>(list[0]->Eval(scope))) {
+    if (!Is<Cell>(list[0])) {
         throw RuntimeError("set-car first argument must be cell");
     }
-    Object* x = list[0]->Eval(scope);
-    As<Cell>(x)->SetFirst(list[1]->Eval(scope));
+    As<Cell>(list[0])->SetFirst(list[1]);
     return nullptr;
 }
 
-Object* SetCdrOperator::Calc(const std::vector<Object*>& list, Object* scope) const {
+Object* SetCdrOperator::Apply(ArgSpan list) const {
     if (list.size() != 2) {
         throw SyntaxError("set-car operator needs exactly 2 arguments");
     }
-    if (!Is<Cell>(list[0]->Eval(scope))) {
+    if (!Is<Cell>(list[0])) {
         throw RuntimeError("set-car first argument must be cell");
     }
-    Object* x = list[0]->Eval(scope);
-    As<Cell>(x)->SetSecond(list[1]->Eval(scope));
+    As<Cell>(list[0])->SetSecond(list[1]);
     return nullptr;
 }
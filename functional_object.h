@@ -1,11 +1,38 @@
+#pragma once
+
 #include "object.h"
+#include "list_helper.h"
+
+#include <functional>
+
+/// Tail calls
+/// A form whose value is the value of another expression (an if branch, the last form of a
+/// lambda body, the last operand of and/or) may leave that expression to its caller in a
+/// TailCall instead of evaluating it. Cell::Eval keeps evaluating such expressions in a loop, so
+/// tail recursion runs in constant C++ stack.
+
+struct TailCall {
+    Object* expr = nullptr;
+    // Scope to evaluate expr in, nullptr if the form returned its value itself.
+    Scope* scope = nullptr;
+    // Frame of the lambda call being finished, which the callee may reuse. Never captured.
+    Scope* spare = nullptr;
+};
+
+// Value of a form called with TailCalc or TailApply.
+Object* Complete(Object* value, const TailCall& tail);
 
 /// Primitive class
 
 class FunctionalObject : public Object {
 public:
-    virtual Object* Calc(Object*, Object*) const;
-    virtual Object* Calc(const std::vector<Object*>&, Object*) const = 0;
+    explicit FunctionalObject(TypeTag tag = TypeTag::SPECIAL_FORM) : Object(tag) {
+    }
+    // args is the list of unevaluated arguments of the call.
+    Object* Calc(Object* args, Object* scope) const;
+    virtual Object* TailCalc(Object* args, Object* scope, TailCall*) const;
+    // Forms which do not override TailCalc receive their arguments as a vector.
+    virtual Object* Calc(const std::vector<Object*>&, Object*) const;
     Object* Eval(Object*) const override {
         throw std::logic_error("can not eval functional object");
     }
@@ -17,10 +44,28 @@ public:
     }
 };
 
+/// Procedures
+/// A procedure evaluates all of its arguments and then works with their values only. Special
+/// forms (quote, if, define, ...) derive from FunctionalObject directly and receive the code of
+/// their arguments instead.
+
+class Procedure : public FunctionalObject {
+public:
+    explicit Procedure(TypeTag tag = TypeTag::PRIMITIVE) : FunctionalObject(tag) {
+    }
+    Object* TailCalc(Object*, Object*, TailCall*) const override;
+    virtual Object* Apply(ArgSpan) const = 0;
+    virtual Object* TailApply(ArgSpan list, TailCall*) const {
+        return Apply(list);
+    }
+};
+
 /// QuoteFunctor
 
 class QuoteFunctor : public FunctionalObject {
 public:
+    QuoteFunctor() : FunctionalObject(TypeTag::QUOTE) {
+    }
     Object* Calc(const std::vector<Object*>&, Object*) const override;
 };
 
@@ -29,47 +74,50 @@ public:
 class BooleanFunctor : public FunctionalObject {
 public:
     BooleanFunctor(const std::function<bool(bool, bool)>& functor, bool stop_value)
-        : functor_(functor), stop_value_(stop_value){};
+        : FunctionalObject(TypeTag::BOOLEAN_FORM), functor_(functor), stop_value_(stop_value){};
 
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* TailCalc(Object*, Object*, TailCall*) const override;
+    bool GetStopValue() const {
+        return stop_value_;
+    }
 
 private:
     std::function<bool(bool, bool)> functor_;
     bool stop_value_;
 };
 
-class BooleanNot : public FunctionalObject {
+class BooleanNot : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
 /// NumberFunctors
 
-class NumberFunctor : public FunctionalObject {
+class NumberFunctor : public Procedure {
 public:
     NumberFunctor(const std::function<int64_t(int64_t, int64_t)>& functor) : functor_(functor){};
     NumberFunctor(const std::function<int64_t(int64_t, int64_t)>& functor, int64_t first)
         : functor_(functor), first_(first){};
 
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 
 private:
     std::function<int64_t(int64_t, int64_t)> functor_;
     std::optional<int64_t> first_;
 };
 
-class NumberAbs : public FunctionalObject {
+class NumberAbs : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
 /// Compare functors
 
-class CompareFunctor : public FunctionalObject {
+class CompareFunctor : public Procedure {
 public:
     CompareFunctor(const std::function<bool(int64_t, int64_t)>& functor) : functor_(functor){};
 
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 
 private:
     std::function<bool(int64_t, int64_t)> functor_;
@@ -78,41 +126,41 @@ private:
 /// Check-type functors
 
 template <class T>
-class CheckTypeFunctor : public FunctionalObject {
+class CheckTypeFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>& list, Object* scope) const {
+    Object* Apply(ArgSpan list) const override {
         if (list.size() != 1) {
             throw RuntimeError("check-type operators works with 1-element list only");
         }
-        return Hp().Make<Boolean>(Is<T>(list.back()->Eval(scope)));
+        return MakeBoolean(Is<T>(list.back()));
     }
 };
 
-class CheckListFunctor : public FunctionalObject {
+class CheckListFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
-class CheckNullFunctor : public FunctionalObject {
+class CheckNullFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
 /// car, cdr and cons functors
 
-class CarFunctor : public FunctionalObject {
+class CarFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
-class CdrFunctor : public FunctionalObject {
+class CdrFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
-class ConsFunctor : public FunctionalObject {
+class ConsFunctor : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
 /// List functors
@@ -122,63 +170,154 @@ public:
     Object* Calc(const std::vector<Object*>&, Object*) const override;
 };
 
-class ListAbstractFunctor : public FunctionalObject {
+class ListAbstractFunctor : public Procedure {
 protected:
-    std::pair<std::vector<Object*>, int64_t> Parse(const std::vector<Object*>&, Object*) const;
+    std::pair<std::vector<Object*>, int64_t> Parse(ArgSpan) const;
 };
 
 class ListTailFunctor : public ListAbstractFunctor {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
 };
 
 class ListRefFunctor : public ListAbstractFunctor {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    Object* Apply(ArgSpan) const override;
+};
+
+/// Higher-order list functions
+/// The procedure comes first and is called on the elements of one or more lists, taken in
+/// lockstep until the shortest list ends.
+
+class MapFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
+};
+
+// Returns an empty list.
+class ForEachFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
+};
+
+// Keeps the elements of one list for which the predicate is not #f.
+class FilterFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
+};
+
+// (fold f init list...) calls (f elem... acc), acc starting with init.
+class FoldFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
+};
+
+// (par-map f list) maps over chunks of one list with ParallelFor. f must be pure: it may not
+// change shared objects with set!, set-car!, set-cdr! or define outside of its own frames.
+class ParallelMapFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
+};
+
+/// Heap statistics
+
+// (gc-stats) returns the HeapStats of the interpreter as an association list of symbols to
+// numbers, times in microseconds. The allocations entry lists the types made at least once.
+class GcStatsFunctor : public Procedure {
+public:
+    Object* Apply(ArgSpan) const override;
 };
 
 /// If operator
 
 class IfOperator : public FunctionalObject {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+    IfOperator() : FunctionalObject(TypeTag::IF) {
+    }
+    Object* TailCalc(Object*, Object*, TailCall*) const override;
 };
 
 /// Set and define operators
 
 class DefineOperator : public FunctionalObject {
 public:
+    DefineOperator() : FunctionalObject(TypeTag::DEFINE) {
+    }
     Object* Calc(const std::vector<Object*>&, Object*) const override;
     Object* DefineFunction(Object*, std::vector<Object*>, Object*) const;
     Object* DefineVariable(Object*, Object*, Object*) const;
 };
 
 class SetOperator : public FunctionalObject {
+public:
+    SetOperator() : FunctionalObject(TypeTag::SET) {
+    }
+
+private:
     Object* Calc(const std::vector<Object*>&, Object*) const override;
 };
 
-class SetCarOperator : public FunctionalObject {
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+class SetCarOperator : public Procedure {
+    Object* Apply(ArgSpan) const override;
 };
 
-class SetCdrOperator : public FunctionalObject {
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
+class SetCdrOperator : public Procedure {
+    Object* Apply(ArgSpan) const override;
 };
 
 /// Lambda operators
 
 class LambdaMaker : public FunctionalObject {
+public:
+    LambdaMaker() : FunctionalObject(TypeTag::LAMBDA_MAKER) {
+    }
+
+private:
     Object* Calc(const std::vector<Object*>&, Object*) const override;
 };
 
-class Lambda : public FunctionalObject {
+class Lambda : public Procedure {
 public:
-    Object* Calc(const std::vector<Object*>&, Object*) const override;
-    Lambda(const std::vector<std::string>& arg_names, std::vector<Object*> body,
+    Object* Apply(ArgSpan) const override;
+    Object* TailApply(ArgSpan, TailCall*) const override;
+    Lambda(const std::vector<const Symbol*>& arg_names, std::vector<Object*> body,
            Scope* parent_scope);
+    // Restores a lambda from its parts, the body is already resolved against the layout.
+    Lambda(std::shared_ptr<const FrameLayout> layout, std::vector<Object*> body,
+           Scope* parent_scope);
+    void Trace(Tracer*) const override;
+
+    const FrameLayout* GetLayout() const {
+        return layout_.get();
+    }
+    const std::vector<Object*>& GetBody() const {
+        return body_;
+    }
+    Scope* GetParentScope() const {
+        return parent_scope_;
+    }
 
 private:
-    std::vector<std::string> arg_names_;
+    std::shared_ptr<const FrameLayout> layout_;
     std::vector<Object*> body_;
     Scope* parent_scope_;
 };
+
+template <>
+struct TypeTags<FunctionalObject> : TagRange<TypeTag::QUOTE, TypeTag::VM_CLOSURE> {};
+template <>
+struct TypeTags<Procedure> : TagRange<TypeTag::PRIMITIVE, TypeTag::VM_CLOSURE> {};
+template <>
+struct TypeTags<QuoteFunctor> : TagRange<TypeTag::QUOTE> {};
+template <>
+struct TypeTags<BooleanFunctor> : TagRange<TypeTag::BOOLEAN_FORM> {};
+template <>
+struct TypeTags<IfOperator> : TagRange<TypeTag::IF> {};
+template <>
+struct TypeTags<DefineOperator> : TagRange<TypeTag::DEFINE> {};
+template <>
+struct TypeTags<SetOperator> : TagRange<TypeTag::SET> {};
+template <>
+struct TypeTags<LambdaMaker> : TagRange<TypeTag::LAMBDA_MAKER> {};
+template <>
+struct TypeTags<Lambda> : TagRange<TypeTag::LAMBDA> {};
@@ -0,0 +1,610 @@
+#include "image.h"
+
+#include "bytecode.h"
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// "SCMIMAGE" as a little-endian word, so an image of a different word order does not match.
+constexpr uint64_t kMagic = 0x4547414d494d4353;
+// Must change together with the format or the TypeTag numbering.
+constexpr uint64_t kVersion = 1;
+
+// A reference takes one word: null is 0 and an immediate number is stored as is, anything else
+// is an index shifted left by 4 with the kind in bits 1-3.
+enum class RefKind : uint64_t { RECORD = 1, SYMBOL, BOOLEAN, BUILTIN, GLOBALS };
+
+uint64_t EncodeRef(RefKind kind, uint64_t index) {
+    return (index << 4) | (static_cast<uint64_t>(kind) << 1);
+}
+
+// Cells and scopes are changed after construction, so only they can be on reference cycles. The
+// reader makes them empty and fills them in once every object exists. Other objects get their
+// references in the constructor and are saved after the objects they refer to.
+bool IsMutable(Object* obj) {
+    return Is<Cell>(obj) || Is<Scope>(obj);
+}
+
+class ChildCollector : public Tracer {
+public:
+    void Visit(Object* obj) override {
+        children.push_back(obj);
+    }
+
+    std::vector<Object*> children;
+};
+
+std::vector<Object*> Children(Object* obj) {
+    ChildCollector collector;
+    obj->Trace(&collector);
+    return std::move(collector.children);
+}
+
+class ImageWriter {
+public:
+    ImageWriter(Scope* globals, const Builtins& builtins) : globals_(globals) {
+        for (const auto& [name, function] : builtins) {
+            builtin_names_.emplace(function, Intern(name));
+        }
+    }
+
+    void Write(OutputSink* out) {
+        std::vector<std::pair<const Symbol*, Object*>> bindings;
+        for (const auto& [name, value] : globals_->GetVariables()) {
+            auto builtin = builtin_names_.find(value);
+            if (builtin != builtin_names_.end() && builtin->second == name) {
+                continue;
+            }
+            bindings.emplace_back(name, value);
+            Add(value);
+        }
+        while (!pending_.empty()) {
+            Object* obj = pending_.back();
+            pending_.pop_back();
+            for (Object* child : Children(obj)) {
+                Add(child);
+            }
+        }
+
+        // Nothing is written before the whole image is built, a failed save leaves no output.
+        std::vector<uint64_t> records;
+        for (Object* obj : objects_) {
+            WriteRecord(obj, &records);
+        }
+        std::vector<uint64_t> binding_words;
+        for (auto [name, value] : bindings) {
+            binding_words.push_back(SymbolIndex(name));
+            binding_words.push_back(Ref(value));
+        }
+        std::vector<uint64_t> layouts;
+        for (const FrameLayout* layout : layouts_) {
+            layouts.push_back(layout->slots.size());
+            for (const Symbol* name : layout->slots) {
+                layouts.push_back(SymbolIndex(name));
+            }
+            layouts.push_back(layout->dynamic.size());
+            for (const Symbol* name : layout->dynamic) {
+                layouts.push_back(SymbolIndex(name));
+            }
+        }
+        std::vector<uint64_t> names;
+        for (const Symbol* symbol : symbols_) {
+            const std::string& name = symbol->GetName();
+            names.push_back(name.size());
+            size_t start = names.size();
+            names.resize(start + (name.size() + 7) / 8);
+            std::memcpy(names.data() + start, name.data(), name.size());
+        }
+
+        std::vector<uint64_t> header = {
+            kMagic,          kVersion,       symbols_.size(), layouts_.size(),
+            objects_.size(), bindings.size()};
+        for (const auto* section : {&header, &names, &layouts, &records, &binding_words}) {
+            out->Write(std::string_view(reinterpret_cast<const char*>(section->data()),
+                                        section->size() * sizeof(uint64_t)));
+        }
+    }
+
+private:
+    bool NeedsRecord(Object* obj) const {
+        return obj && !IsImmediate(obj) && obj != globals_ && !Is<Symbol>(obj) &&
+               !Is<Boolean>(obj) && !builtin_names_.contains(obj) && !ids_.contains(obj);
+    }
+
+    void Add(Object* root) {
+        if (!NeedsRecord(root)) {
+            return;
+        }
+        if (IsMutable(root)) {
+            AddMutable(root);
+            return;
+        }
+        // Post-order over the other objects, which are never on a cycle of their own.
+        std::vector<std::pair<Object*, bool>> stack = {{root, false}};
+        while (!stack.empty()) {
+            auto [obj, expanded] = stack.back();
+            if (expanded || ids_.contains(obj)) {
+                stack.pop_back();
+                if (!ids_.contains(obj)) {
+                    Assign(obj);
+                }
+                continue;
+            }
+            if (Is<FunctionalObject>(obj) && !Is<Lambda>(obj) && !Is<VmClosure>(obj)) {
+                throw RuntimeError("image can not contain a builtin which has no name");
+            }
+            stack.back().second = true;
+            for (Object* child : Children(obj)) {
+                if (!NeedsRecord(child)) {
+                    continue;
+                }
+                if (IsMutable(child)) {
+                    AddMutable(child);
+                } else {
+                    stack.emplace_back(child, false);
+                }
+            }
+        }
+    }
+
+    // The reader makes a scope together with its parent, so parents are numbered first. The
+    // references of mutable objects are added later, from pending_.
+    void AddMutable(Object* obj) {
+        std::vector<Object*> chain;
+        for (Object* cur = obj; NeedsRecord(cur);
+             cur = Is<Scope>(cur) ? As<Scope>(cur)->GetParent() : nullptr) {
+            chain.push_back(cur);
+        }
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            Assign(*it);
+            pending_.push_back(*it);
+        }
+    }
+
+    void Assign(Object* obj) {
+        ids_.emplace(obj, objects_.size());
+        objects_.push_back(obj);
+    }
+
+    uint64_t SymbolIndex(const Symbol* symbol) {
+        auto [it, inserted] = symbol_ids_.emplace(symbol, symbols_.size());
+        if (inserted) {
+            symbols_.push_back(symbol);
+        }
+        return it->second;
+    }
+
+    // 0 for no layout, the index plus one otherwise.
+    uint64_t LayoutRef(const FrameLayout* layout) {
+        if (!layout) {
+            return 0;
+        }
+        auto [it, inserted] = layout_ids_.emplace(layout, layouts_.size());
+        if (inserted) {
+            layouts_.push_back(layout);
+        }
+        return it->second + 1;
+    }
+
+    uint64_t Ref(Object* obj) {
+        if (!obj) {
+            return 0;
+        }
+        if (IsImmediate(obj)) {
+            return reinterpret_cast<uintptr_t>(obj);
+        }
+        if (obj == globals_) {
+            return EncodeRef(RefKind::GLOBALS, 0);
+        }
+        if (Is<Symbol>(obj)) {
+            return EncodeRef(RefKind::SYMBOL, SymbolIndex(As<Symbol>(obj)));
+        }
+        if (Is<Boolean>(obj)) {
+            return EncodeRef(RefKind::BOOLEAN, As<Boolean>(obj)->GetValue());
+        }
+        if (auto builtin = builtin_names_.find(obj); builtin != builtin_names_.end()) {
+            return EncodeRef(RefKind::BUILTIN, SymbolIndex(builtin->second));
+        }
+        return EncodeRef(RefKind::RECORD, ids_.at(obj));
+    }
+
+    // A record is a header word with the tag and the number of the following words.
+    void WriteRecord(Object* obj, std::vector<uint64_t>* out) {
+        size_t header = out->size();
+        out->push_back(0);
+        switch (obj->GetTag()) {
+            case TypeTag::NUMBER:
+                out->push_back(As<Number>(obj)->GetValue());
+                break;
+            case TypeTag::CELL:
+                out->push_back(Ref(As<Cell>(obj)->GetFirst()));
+                out->push_back(Ref(As<Cell>(obj)->GetSecond()));
+                break;
+            case TypeTag::SCOPE: {
+                Scope* scope = As<Scope>(obj);
+                const FrameLayout* layout = scope->GetLayout();
+                size_t slot_count = layout ? layout->slots.size() : 0;
+                out->push_back(Ref(scope->GetParent()));
+                out->push_back(LayoutRef(layout));
+                out->push_back(scope->Captured());
+                out->push_back(slot_count);
+                for (size_t i = 0; i < slot_count; ++i) {
+                    out->push_back(Ref(scope->GetSlot(i)));
+                }
+                out->push_back(scope->GetVariables().size());
+                for (const auto& [name, value] : scope->GetVariables()) {
+                    out->push_back(SymbolIndex(name));
+                    out->push_back(Ref(value));
+                }
+                break;
+            }
+            case TypeTag::LOCAL_REF: {
+                LocalRef* ref = As<LocalRef>(obj);
+                out->push_back(SymbolIndex(ref->GetName()));
+                out->push_back(ref->GetDepth());
+                out->push_back(ref->GetSlot());
+                break;
+            }
+            case TypeTag::LAMBDA: {
+                Lambda* lambda = As<Lambda>(obj);
+                out->push_back(LayoutRef(lambda->GetLayout()));
+                out->push_back(Ref(lambda->GetParentScope()));
+                for (Object* instruction : lambda->GetBody()) {
+                    out->push_back(Ref(instruction));
+                }
+                break;
+            }
+            case TypeTag::CODE_BLOCK: {
+                CodeBlock* code = As<CodeBlock>(obj);
+                out->push_back(LayoutRef(code->GetLayout().get()));
+                out->push_back(code->GetCode().size());
+                for (const Instruction& instruction : code->GetCode()) {
+                    out->push_back(static_cast<uint64_t>(instruction.op));
+                    out->push_back(uint64_t{instruction.a} << 32 | instruction.b);
+                }
+                for (Object* constant : code->GetConstants()) {
+                    out->push_back(Ref(constant));
+                }
+                break;
+            }
+            case TypeTag::VM_CLOSURE:
+                out->push_back(Ref(As<VmClosure>(obj)->GetCode()));
+                out->push_back(Ref(As<VmClosure>(obj)->GetEnv()));
+                break;
+            default:
+                throw std::logic_error("image writer: unexpected object");
+        }
+        (*out)[header] = static_cast<uint64_t>(obj->GetTag()) | (out->size() - header - 1) << 8;
+    }
+
+    Scope* globals_;
+    std::unordered_map<const Object*, const Symbol*> builtin_names_;
+    std::unordered_map<const Object*, uint64_t> ids_;
+    std::vector<Object*> objects_;
+    std::vector<Object*> pending_;
+    std::unordered_map<const Symbol*, uint64_t> symbol_ids_;
+    std::vector<const Symbol*> symbols_;
+    std::unordered_map<const FrameLayout*, uint64_t> layout_ids_;
+    std::vector<const FrameLayout*> layouts_;
+};
+
+// Bounds checked reading of the words of an image.
+class Cursor {
+public:
+    explicit Cursor(std::string_view data) : data_(data) {
+    }
+
+    uint64_t Word() {
+        if (data_.size() - pos_ < sizeof(uint64_t)) {
+            throw RuntimeError("image is truncated");
+        }
+        uint64_t word;
+        std::memcpy(&word, data_.data() + pos_, sizeof(word));
+        pos_ += sizeof(word);
+        return word;
+    }
+    // A number of following items each taking at least one word.
+    size_t Count() {
+        uint64_t count = Word();
+        if (count > Left()) {
+            throw RuntimeError("image is truncated");
+        }
+        return count;
+    }
+    std::string_view Bytes(size_t size) {
+        size_t words = size / 8 + (size % 8 != 0);
+        if (size > data_.size() || words > Left()) {
+            throw RuntimeError("image is truncated");
+        }
+        std::string_view bytes = data_.substr(pos_, size);
+        pos_ += words * sizeof(uint64_t);
+        return bytes;
+    }
+    // Splits off the next words into a cursor of their own.
+    Cursor Take(size_t words) {
+        if (words > Left()) {
+            throw RuntimeError("image is truncated");
+        }
+        Cursor part(data_.substr(pos_, words * sizeof(uint64_t)));
+        pos_ += words * sizeof(uint64_t);
+        return part;
+    }
+    size_t Left() const {
+        return (data_.size() - pos_) / sizeof(uint64_t);
+    }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+class ImageReader {
+public:
+    ImageReader(Scope* globals, const Builtins& builtins)
+        : globals_(globals), builtins_(builtins) {
+    }
+
+    void Read(std::string_view image) {
+        Cursor in(image);
+        if (in.Word() != kMagic || in.Word() != kVersion) {
+            throw RuntimeError("not an image of this version");
+        }
+        size_t symbol_count = in.Count();
+        size_t layout_count = in.Count();
+        size_t record_count = in.Count();
+        size_t binding_count = in.Count();
+
+        symbols_.reserve(symbol_count);
+        for (size_t i = 0; i < symbol_count; ++i) {
+            symbols_.push_back(Intern(in.Bytes(in.Word())));
+        }
+        layouts_.reserve(layout_count);
+        for (size_t i = 0; i < layout_count; ++i) {
+            auto layout = std::make_shared<FrameLayout>();
+            for (size_t slot_count = in.Count(); slot_count > 0; --slot_count) {
+                layout->slots.push_back(GetSymbol(in.Word()));
+            }
+            for (size_t dynamic_count = in.Count(); dynamic_count > 0; --dynamic_count) {
+                layout->dynamic.insert(GetSymbol(in.Word()));
+            }
+            layouts_.push_back(std::move(layout));
+        }
+        ReadRecords(&in, record_count);
+        // Defined once the whole image is checked, a malformed image defines nothing.
+        std::vector<std::pair<Symbol*, Object*>> bindings;
+        bindings.reserve(binding_count);
+        for (size_t i = 0; i < binding_count; ++i) {
+            Symbol* name = GetSymbol(in.Word());
+            bindings.emplace_back(name, GetRef(in.Word()));
+        }
+        if (in.Left() > 0) {
+            throw RuntimeError("image has data after its end");
+        }
+        for (auto [name, value] : bindings) {
+            globals_->Define(name, value);
+        }
+    }
+
+private:
+    struct Record {
+        TypeTag tag;
+        Cursor fields;
+    };
+
+    void ReadRecords(Cursor* in, size_t count) {
+        // Finds the records and makes the mutable objects, scopes together with their parents.
+        std::vector<Record> records;
+        records.reserve(count);
+        objects_.assign(count, nullptr);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t header = in->Word();
+            if ((header & 0xff) > static_cast<uint64_t>(TypeTag::VM_CLOSURE)) {
+                throw RuntimeError("image contains an unknown object");
+            }
+            Record record{static_cast<TypeTag>(header & 0xff), in->Take(header >> 8)};
+            if (record.tag == TypeTag::CELL) {
+                objects_[i] = Hp().Make<Cell>(nullptr);
+            } else if (record.tag == TypeTag::SCOPE) {
+                Cursor fields = record.fields;
+                Scope* parent = Expect<Scope>(GetRef(fields.Word()), true);
+                if (auto layout = GetLayout(fields.Word(), true)) {
+                    objects_[i] = Hp().Make<Scope>(parent, std::move(layout));
+                } else {
+                    objects_[i] = Hp().Make<Scope>(parent);
+                }
+            }
+            records.push_back(record);
+        }
+        // The other objects only refer to the objects before them.
+        for (size_t i = 0; i < count; ++i) {
+            if (!objects_[i]) {
+                objects_[i] = MakeObject(&records[i]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (records[i].tag == TypeTag::CELL) {
+                Cell* cell = As<Cell>(objects_[i]);
+                cell->SetFirst(GetRef(records[i].fields.Word()));
+                cell->SetSecond(GetRef(records[i].fields.Word()));
+            } else if (records[i].tag == TypeTag::SCOPE) {
+                FillScope(As<Scope>(objects_[i]), &records[i].fields);
+            }
+        }
+    }
+
+    Object* MakeObject(Record* record) {
+        Cursor* fields = &record->fields;
+        switch (record->tag) {
+            case TypeTag::NUMBER:
+                return Hp().Make<Number>(static_cast<int64_t>(fields->Word()));
+            case TypeTag::LOCAL_REF: {
+                Symbol* name = GetSymbol(fields->Word());
+                size_t depth = fields->Word();
+                return Hp().Make<LocalRef>(name, depth, fields->Word());
+            }
+            case TypeTag::LAMBDA: {
+                auto layout = GetLayout(fields->Word(), false);
+                Scope* parent = Expect<Scope>(GetRef(fields->Word()), false);
+                std::vector<Object*> body;
+                while (fields->Left() > 0) {
+                    body.push_back(GetRef(fields->Word()));
+                }
+                if (body.empty()) {
+                    throw RuntimeError("image contains a lambda without body");
+                }
+                return Hp().Make<Lambda>(std::move(layout), std::move(body), parent);
+            }
+            case TypeTag::CODE_BLOCK: {
+                CodeBlock* code = Hp().Make<CodeBlock>(GetLayout(fields->Word(), true));
+                for (size_t size = fields->Count(); size > 0; --size) {
+                    uint64_t op = fields->Word();
+                    uint64_t operands = fields->Word();
+                    if (op > static_cast<uint64_t>(OpCode::INTERPRET)) {
+                        throw RuntimeError("image contains an unknown instruction");
+                    }
+                    code->Emit(static_cast<OpCode>(op), operands >> 32, operands & 0xffffffff);
+                }
+                while (fields->Left() > 0) {
+                    code->AddConstant(GetRef(fields->Word()));
+                }
+                return code;
+            }
+            case TypeTag::VM_CLOSURE: {
+                CodeBlock* code = Expect<CodeBlock>(GetRef(fields->Word()), false);
+                return Hp().Make<VmClosure>(code, Expect<Scope>(GetRef(fields->Word()), false));
+            }
+            default:
+                throw RuntimeError("image contains an object which can not be saved");
+        }
+    }
+
+    void FillScope(Scope* scope, Cursor* fields) {
+        fields->Word();  // parent and layout are already set
+        fields->Word();
+        if (fields->Word()) {
+            scope->MarkCaptured();
+        }
+        size_t slot_count = fields->Count();
+        const FrameLayout* layout = scope->GetLayout();
+        if (slot_count != (layout ? layout->slots.size() : 0)) {
+            throw RuntimeError("image contains a scope which does not match its layout");
+        }
+        for (size_t i = 0; i < slot_count; ++i) {
+            scope->SetSlot(i, GetRef(fields->Word()));
+        }
+        for (size_t count = fields->Count(); count > 0; --count) {
+            Symbol* name = GetSymbol(fields->Word());
+            scope->Define(name, GetRef(fields->Word()));
+        }
+    }
+
+    Symbol* GetSymbol(uint64_t index) {
+        if (index >= symbols_.size()) {
+            throw RuntimeError("image refers to an unknown symbol");
+        }
+        return symbols_[index];
+    }
+
+    std::shared_ptr<const FrameLayout> GetLayout(uint64_t ref, bool optional) {
+        if (ref == 0 && optional) {
+            return nullptr;
+        }
+        if (ref == 0 || ref > layouts_.size()) {
+            throw RuntimeError("image refers to an unknown layout");
+        }
+        return layouts_[ref - 1];
+    }
+
+    Object* GetRef(uint64_t word) {
+        if (word == 0) {
+            return nullptr;
+        }
+        if (word & 1) {
+            return reinterpret_cast<Object*>(static_cast<uintptr_t>(word));
+        }
+        uint64_t index = word >> 4;
+        switch (static_cast<RefKind>(word >> 1 & 7)) {
+            case RefKind::RECORD:
+                if (index >= objects_.size() || !objects_[index]) {
+                    throw RuntimeError("image refers to an object which is not made yet");
+                }
+                return objects_[index];
+            case RefKind::SYMBOL:
+                return GetSymbol(index);
+            case RefKind::BOOLEAN:
+                if (index > 1) {
+                    throw RuntimeError("image contains a bad boolean");
+                }
+                return MakeBoolean(index);
+            case RefKind::BUILTIN: {
+                const std::string& name = GetSymbol(index)->GetName();
+                auto builtin = builtins_.find(name);
+                if (builtin == builtins_.end()) {
+                    throw RuntimeError("image refers to an unknown builtin " + name);
+                }
+                return builtin->second;
+            }
+            case RefKind::GLOBALS:
+                return globals_;
+            default:
+                throw RuntimeError("image contains a bad reference");
+        }
+    }
+
+    template <class T>
+    T* Expect(Object* obj, bool optional) {
+        if (!obj && optional) {
+            return nullptr;
+        }
+        if (!Is<T>(obj)) {
+            throw RuntimeError("image contains a reference of a wrong type");
+        }
+        return As<T>(obj);
+    }
+
+    Scope* globals_;
+    const Builtins& builtins_;
+    std::vector<Symbol*> symbols_;
+    std::vector<std::shared_ptr<const FrameLayout>> layouts_;
+    std::vector<Object*> objects_;
+};
+
+}  // namespace
+
+void WriteImage(Scope* globals, const Builtins& builtins, OutputSink* out) {
+    ImageWriter(globals, builtins).Write(out);
+}
+
+void ReadImage(std::string_view image, Scope* globals, const Builtins& builtins) {
+    ImageReader(globals, builtins).Read(image);
+}
+
+void SaveImage(const std::string& path, Scope* globals, const Builtins& builtins) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "can not open " + path);
+    }
+    try {
+        FdSink sink(fd);
+        WriteImage(globals, builtins, &sink);
+        sink.Flush();
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd) < 0) {
+        throw std::system_error(errno, std::generic_category(), "can not write " + path);
+    }
+}
+
+void LoadImage(const std::string& path, Scope* globals, const Builtins& builtins) {
+    MappedFile file(path);
+    ReadImage(file.GetData(), globals, builtins);
+}
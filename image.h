@@ -0,0 +1,36 @@
+#pragma once
+
+#include "object.h"
+#include "serializer.h"
+
+#include <map>
+#include <string>
+#include <string_view>
+
+/// Images
+/// The global definitions of an interpreter saved in a compact binary form, so a library can be
+/// loaded without tokenizing, parsing and evaluating it again. Lambdas keep their resolved bodies
+/// and compiled code blocks are saved as well.
+///
+/// An image is a sequence of 64-bit words: a symbol name table, the frame layouts and a record
+/// for every saved heap object, in which references are record or symbol indices. Loading maps
+/// the file and makes all objects in one pass over the records, then fixes the indices up into
+/// pointers. Symbols are interned again and builtins are looked up by name, so an image does not
+/// depend on the addresses of the process that saved it, but it does depend on the word order
+/// and the object layouts of the build.
+///
+/// Images are trusted: the structure is checked, the code of compiled blocks is not.
+
+// Builtin functions and special forms by name, they are saved as references to their names.
+using Builtins = std::map<std::string, Object*>;
+
+// Saves the bindings of globals, except builtins bound to their own names. Objects referring to
+// globals refer to the scope the image is loaded into.
+void WriteImage(Scope* globals, const Builtins& builtins, OutputSink* out);
+// Defines the saved bindings in globals. Throws RuntimeError if the image is malformed, without
+// defining any of them.
+void ReadImage(std::string_view image, Scope* globals, const Builtins& builtins);
+
+// Throw std::system_error if the file can not be written or read.
+void SaveImage(const std::string& path, Scope* globals, const Builtins& builtins);
+void LoadImage(const std::string& path, Scope* globals, const Builtins& builtins);
@@ -0,0 +1,60 @@
+#include "interpreter_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+std::vector<std::unique_ptr<Interpreter>> MakeInterpreters(
+    size_t count, std::shared_ptr<const Prelude> prelude, Interpreter::Engine engine) {
+    if (!prelude) {
+        prelude = Interpreter(engine).Snapshot();
+    }
+    std::vector<std::unique_ptr<Interpreter>> interpreters;
+    for (size_t i = 0; i < std::max<size_t>(count, 1); ++i) {
+        interpreters.push_back(std::make_unique<Interpreter>(prelude, engine));
+    }
+    return interpreters;
+}
+
+}  // namespace
+
+InterpreterPool::InterpreterPool(size_t thread_count, std::shared_ptr<const Prelude> prelude,
+                                 Engine engine)
+    : interpreters_(MakeInterpreters(thread_count, std::move(prelude), engine)),
+      pool_(interpreters_.size()) {
+}
+
+std::future<std::string> InterpreterPool::Submit(std::string program) {
+    std::future<std::string> result;
+    pool_.Submit(MakeTask(std::move(program), &result));
+    return result;
+}
+
+std::vector<std::future<std::string>> InterpreterPool::Submit(std::vector<std::string> programs) {
+    std::vector<std::future<std::string>> results(programs.size());
+    std::vector<ThreadPool::Task> tasks;
+    tasks.reserve(programs.size());
+    for (size_t i = 0; i < programs.size(); ++i) {
+        tasks.push_back(MakeTask(std::move(programs[i]), &results[i]));
+    }
+    pool_.Submit(std::move(tasks));
+    return results;
+}
+
+ThreadPool::Task InterpreterPool::MakeTask(std::string program, std::future<std::string>* result) {
+    // Shared, a task must be copyable.
+    auto promise = std::make_shared<std::promise<std::string>>();
+    *result = promise->get_future();
+    return [this, promise, program = std::move(program)](size_t worker) {
+        Interpreter& interpreter = *interpreters_[worker];
+        try {
+            std::string output;
+            StringSink sink(&output);
+            interpreter.Run(std::string_view(program), &sink);
+            promise->set_value(std::move(output));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+        interpreter.Reset();
+    };
+}
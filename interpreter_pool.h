@@ -0,0 +1,37 @@
+#pragma once
+
+#include "scheme.h"
+#include "thread_pool.h"
+
+#include <future>
+
+/// Interpreter pool
+/// Evaluates independent programs concurrently. Every worker thread owns an interpreter made from
+/// a common prelude: a program sees the definitions of the prelude only, its own definitions are
+/// dropped once it is done.
+
+class InterpreterPool {
+public:
+    using Engine = Interpreter::Engine;
+
+    // Without a prelude the interpreters start with the builtins only.
+    explicit InterpreterPool(size_t thread_count = std::thread::hardware_concurrency(),
+                             std::shared_ptr<const Prelude> prelude = nullptr,
+                             Engine engine = Engine::TREE_WALKER);
+
+    // The result is the value of every form of the program followed by a newline, as written by
+    // Interpreter::Run(program, out). The future holds the error if the program fails.
+    std::future<std::string> Submit(std::string program);
+    std::vector<std::future<std::string>> Submit(std::vector<std::string> programs);
+
+    size_t Size() const {
+        return interpreters_.size();
+    }
+
+private:
+    ThreadPool::Task MakeTask(std::string program, std::future<std::string>* result);
+
+    std::vector<std::unique_ptr<Interpreter>> interpreters_;
+    // Declared last, so the workers are joined before the interpreters are destroyed.
+    ThreadPool pool_;
+};
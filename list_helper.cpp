@@ -2,26 +2,21 @@
 
 std::vector<Object*> ObjectToList(Object* o) {
     std::vector<Object*> ret;
-    if (!o) {
-        return ret;
-    }
-    if (!Is<Cell>(o)) {
-        throw RuntimeError("list helper: object to list: root must be a cell");
-    }
-    while (true) {
-        ret.push_back(As<Cell>(o)->GetFirst());
-        if (!As<Cell>(o)->GetSecond()) {
-            break;
-        }
-        if (!Is<Cell>(As<Cell>(o)->GetSecond())) {
-            ret.push_back(As<Cell>(o)->GetSecond());
-            break;
-        }
-        o = As<Cell>(o)->GetSecond();
-    }
+    ForEachElement(o, [&ret](Object* elem) { ret.push_back(elem); });
     return ret;
 }
 
+size_t UnpackList(Object* o, Object** out, size_t capacity) {
+    size_t size = 0;
+    ForEachElement(o, [&](Object* elem) {
+        if (size < capacity) {
+            out[size] = elem;
+        }
+        ++size;
+    });
+    return size;
+}
+
 Object* ListToObject(const std::vector<Object*>& list) {
     if (list.empty()) {
         return nullptr;
@@ -37,4 +32,25 @@ Object* ListToObject(const std::vector<Object*>& list) {
         current_cell_ptr->SetFirst(sp);
     }
     return first_cell_ptr;
-}
\ No newline at end of file
+}
+
+EvaluatedArgs::EvaluatedArgs(Object* list, Object* scope) {
+    ForEachElement(list, [&](Object* cur) {
+        if (!cur) {
+            throw RuntimeError("list contains empty sublist");
+        }
+        Push(Evaluate(cur, scope));
+    });
+}
+
+void EvaluatedArgs::Push(Object* value) {
+    if (size_ < kInline) {
+        inline_[size_++] = value;
+        return;
+    }
+    if (size_ == kInline) {
+        spill_.assign(inline_.begin(), inline_.end());
+    }
+    spill_.push_back(value);
+    ++size_;
+}
@@ -1,24 +1,63 @@
+#pragma once
+
 #include "object.h"
 
+#include <array>
+#include <span>
+
+// Evaluated arguments of a procedure call.
+using ArgSpan = std::span<Object* const>;
+
+// Calls f for every element of a list, an improper tail counts as the last element.
+template <class F>
+void ForEachElement(Object* o, F&& f) {
+    if (!o) {
+        return;
+    }
+    if (!Is<Cell>(o)) {
+        throw RuntimeError("list helper: object to list: root must be a cell");
+    }
+    while (true) {
+        f(As<Cell>(o)->GetFirst());
+        Object* next = As<Cell>(o)->GetSecond();
+        if (!next) {
+            return;
+        }
+        if (!Is<Cell>(next)) {
+            f(next);
+            return;
+        }
+        o = next;
+    }
+}
+
 std::vector<Object*> ObjectToList(Object*);
 
+// Stores the first capacity elements of a list into out and returns the length of the list.
+size_t UnpackList(Object*, Object** out, size_t capacity);
+
 Object* ListToObject(const std::vector<Object*>&);
 
-template <typename T>
-std::vector<T*> EvalList(const std::vector<Object*>&, Object*);
+// Evaluates the argument list of a call without building intermediate vectors. Up to kInline
+// values are kept inside the object, so short calls do not allocate.
+class EvaluatedArgs {
+public:
+    static constexpr size_t kInline = 8;
 
-template <typename T>
-std::vector<T*> EvalList(const std::vector<Object*>& list, Object* scope) {
-    std::vector<T*> ret;
-    for (Object* cur : list) {
-        if (!cur) {
-            throw RuntimeError("list contains empty sublist");
-        }
-        Object* cur_eval = cur->Eval(scope);
-        if (!Is<T>(cur_eval)) {
-            throw RuntimeError("cant evaluate list");
+    EvaluatedArgs(Object* list, Object* scope);
+    EvaluatedArgs(const EvaluatedArgs& other) = delete;
+
+    ArgSpan Get() const {
+        if (size_ <= kInline) {
+            return ArgSpan(inline_.data(), size_);
         }
-        ret.push_back(As<T>(cur_eval));
+        return spill_;
     }
-    return ret;
-}
\ No newline at end of file
+
+private:
+    void Push(Object* value);
+
+    std::array<Object*, kInline> inline_;
+    std::vector<Object*> spill_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/// Read-only memory mapping of a whole file.
+/// Throws std::system_error if the file can not be opened or mapped.
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile& other) = delete;
+    ~MappedFile();
+
+    std::string_view GetData() const {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
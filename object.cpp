@@ -1,82 +1,585 @@
 #include "functional_object.h"
+#include "list_helper.h"
+#include "parallel.h"
+#include "serializer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 void Heap::CleanUp(Object* root) {
-    used_.clear();
-    for (Object* cur : objects_) {
-        cur->Unmark();
+    Clock::time_point start = Clock::now();
+    CollectYoung(root);
+    if (phase_ == Phase::IDLE && old_.size() > old_threshold_) {
+        if (pause_budget_.count() == 0) {
+            CollectOld(root);
+        } else {
+            StartCycle(root);
+        }
+    }
+    if (phase_ != Phase::IDLE) {
+        if (old_.size() > 2 * old_threshold_) {
+            // The program promotes objects faster than the slices collect them.
+            FinishCycle();
+        } else {
+            Step(Clock::now() + pause_budget_);
+        }
+    }
+    EndPause(start);
+}
+
+void Heap::CleanUpFull(Object* root) {
+    Clock::time_point start = Clock::now();
+    CollectYoung(root);
+    FinishCycle();
+    CollectOld(root);
+    FinishCycle();
+    EndPause(start);
+}
+
+void Heap::EndPause(Clock::time_point start) {
+    std::chrono::nanoseconds pause = Clock::now() - start;
+    stats_.last_pause = pause;
+    stats_.max_pause = std::max(stats_.max_pause, pause);
+    stats_.total_pause += pause;
+    if (on_collection_) {
+        on_collection_(GetStats());
+    }
+}
+
+HeapStats Heap::GetStats() const {
+    HeapStats stats = stats_;
+    stats.young_objects = young_.size();
+    stats.old_objects = old_.size();
+    if (phase_ == Phase::SWEEPING) {
+        stats.old_objects -= sweep_index_ - swept_alive_;
+    }
+    return stats;
+}
+
+Heap::~Heap() {
+    // Fills the hole the sweep leaves in old_.
+    if (phase_ == Phase::SWEEPING) {
+        FinishCycle();
+    }
+    for (Object* alive : young_) {
+        Destroy(alive);
+    }
+    for (Object* alive : old_) {
+        Destroy(alive);
+    }
+}
+
+void Heap::CollectYoung(Object* root) {
+    Marker marker(this, true);
+    marker.Visit(root);
+    for (Object* owner : remembered_) {
+        owner->remembered_ = false;
+        owner->Trace(&marker);
+    }
+    remembered_.clear();
+    marker.Drain();
+    size_t promoted = 0;
+    for (Object* cur : young_) {
+        if (!cur->Marked()) {
+            Destroy(cur);
+        } else {
+            ++promoted;
+            cur->generation_ = Generation::OLD;
+            old_.push_back(cur);
+            if (phase_ == Phase::MARKING) {
+                // Stays marked, as a gray object.
+                gray_.push_back(cur);
+            } else {
+                cur->Unmark();
+            }
+        }
+    }
+    ++stats_.minor_collections;
+    stats_.young_collected += young_.size();
+    stats_.young_promoted += promoted;
+    stats_.last_young_collected = young_.size();
+    stats_.last_young_promoted = promoted;
+    young_.clear();
+}
+
+// Marks everything reachable from a root with several threads. Every marker traces the objects
+// of a private stack and moves the oldest ones into its shared stack once the private one grows,
+// idle markers take objects from their own shared stack or steal them from the others. The mark
+// bits are set atomically, so every object is traced once. pending_ counts the objects marked
+// and not traced yet; every marker adds its own counts before sharing objects and before looking
+// for more, so pending_ only drops to zero once all objects are traced.
+class Heap::ParallelMarker {
+public:
+    ParallelMarker(size_t markers, Object* root) : stacks_(markers) {
+        for (auto& stack : stacks_) {
+            stack = std::make_unique<SharedStack>();
+        }
+        if (TryMark(root)) {
+            stacks_[0]->objects.push_back(root);
+            pending_ = 1;
+        }
+    }
+
+    void Run(size_t index) {
+        Local local;
+        while (true) {
+            if (local.objects.empty()) {
+                Publish(&local);
+                if (!Take(index, &local.objects)) {
+                    if (pending_ == 0) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            Object* cur = local.objects.back();
+            local.objects.pop_back();
+            cur->Trace(&local);
+            --local.pending;
+            if (local.objects.size() >= 2 * kShareBatch) {
+                Share(index, &local);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kShareBatch = 64;
+
+    struct SharedStack {
+        std::mutex mutex;
+        std::vector<Object*> objects;
+    };
+
+    struct Local : Tracer {
+        void Visit(Object* obj) override {
+            if (TryMark(obj)) {
+                objects.push_back(obj);
+                ++pending;
+            }
+        }
+
+        std::vector<Object*> objects;
+        // Change of pending_ not added yet.
+        int64_t pending = 0;
+    };
+
+    static bool TryMark(Object* obj) {
+        if (!obj || IsImmediate(obj) || obj->generation_ == Generation::PERMANENT) {
+            return false;
+        }
+        std::atomic_ref<bool> marked(obj->marked_);
+        return !marked.load(std::memory_order_relaxed) &&
+               !marked.exchange(true, std::memory_order_relaxed);
+    }
+
+    void Publish(Local* local) {
+        if (local->pending != 0) {
+            pending_ += local->pending;
+            local->pending = 0;
+        }
+    }
+
+    void Share(size_t index, Local* local) {
+        SharedStack& shared = *stacks_[index];
+        std::lock_guard lock(shared.mutex);
+        if (shared.objects.size() >= kShareBatch) {
+            return;
+        }
+        Publish(local);
+        auto first = local->objects.begin();
+        shared.objects.insert(shared.objects.end(), first, first + kShareBatch);
+        local->objects.erase(first, first + kShareBatch);
+    }
+
+    bool Take(size_t index, std::vector<Object*>* out) {
+        for (size_t i = 0; i < stacks_.size(); ++i) {
+            SharedStack& shared = *stacks_[(index + i) % stacks_.size()];
+            std::lock_guard lock(shared.mutex);
+            if (!shared.objects.empty()) {
+                size_t count = std::min(shared.objects.size(), kShareBatch);
+                out->assign(shared.objects.end() - count, shared.objects.end());
+                shared.objects.resize(shared.objects.size() - count);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<SharedStack>> stacks_;
+    std::atomic<int64_t> pending_ = 0;
+};
+
+void Heap::CollectOld(Object* root) {
+    if (root) {
+        Clock::time_point start = Clock::now();
+        // The root may live outside of the heap, so its mark bit is not reset by the sweep.
+        root->Unmark();
+        size_t markers = std::thread::hardware_concurrency();
+        if (markers > 1 && old_.size() >= kParallelMarkThreshold) {
+            ParallelMarker marker(markers, root);
+            ParallelRun(markers, [&marker](size_t index) { marker.Run(index); });
+        } else {
+            Marker marker(this, false);
+            marker.Visit(root);
+            marker.Drain();
+        }
+        stats_.mark_time += Clock::now() - start;
+    }
+    StartSweep();
+}
+
+void Heap::StartCycle(Object* root) {
+    phase_ = Phase::MARKING;
+    if (root) {
+        // The root may live outside of the heap, so its mark bit is not reset by the sweep.
+        root->Unmark();
+        Shade(root);
+    }
+}
+
+void Heap::Step(Clock::time_point deadline) {
+    Clock::time_point start = Clock::now();
+    if (phase_ == Phase::MARKING) {
+        bool done = MarkSome(deadline);
+        Clock::time_point end = Clock::now();
+        stats_.mark_time += end - start;
+        start = end;
+        if (done) {
+            StartSweep();
+        }
+    }
+    if (phase_ != Phase::SWEEPING) {
+        return;
+    }
+    Clock::time_point now;
+    do {
+        SweepSome(kSliceWork);
+        now = Clock::now();
+    } while (phase_ == Phase::SWEEPING && now < deadline);
+    stats_.sweep_time += now - start;
+}
+
+bool Heap::MarkSome(Clock::time_point deadline) {
+    Shader shader(this);
+    do {
+        for (size_t i = 0; i < kSliceWork && !gray_.empty(); ++i) {
+            Object* cur = gray_.back();
+            gray_.pop_back();
+            cur->Trace(&shader);
+        }
+    } while (!gray_.empty() && Clock::now() < deadline);
+    return gray_.empty();
+}
+
+void Heap::StartSweep() {
+    phase_ = Phase::SWEEPING;
+    swept_alive_ = 0;
+    sweep_index_ = 0;
+    sweep_end_ = old_.size();
+}
+
+void Heap::SweepSome(size_t count) {
+    size_t end = std::min(sweep_end_, sweep_index_ + count);
+    for (; sweep_index_ < end; ++sweep_index_) {
+        Object* cur = old_[sweep_index_];
+        if (!cur->Marked()) {
+            Destroy(cur);
+        } else {
+            cur->Unmark();
+            old_[swept_alive_++] = cur;
+        }
+    }
+    if (sweep_index_ < sweep_end_) {
+        return;
     }
-    Mark(root);
-    std::vector<Object*> alive_objects;
-    for (Object* cur : objects_) {
-        if (cur != nullptr && !cur->Marked()) {
-            delete cur;
-        } else if (cur != nullptr) {
-            alive_objects.push_back(cur);
+    old_.erase(old_.begin() + swept_alive_, old_.begin() + sweep_end_);
+    phase_ = Phase::IDLE;
+    old_threshold_ = std::max(kMinOldThreshold, 2 * old_.size());
+    ++stats_.major_collections;
+    stats_.live_after_major = old_.size();
+}
+
+void Heap::Absorb(Heap* other) {
+    arena_.Absorb(&other->arena_);
+    young_.insert(young_.end(), other->young_.begin(), other->young_.end());
+    old_.insert(old_.end(), other->old_.begin(), other->old_.end());
+    if (phase_ == Phase::MARKING) {
+        for (Object* obj : other->old_) {
+            Shade(obj);
         }
     }
-    objects_ = alive_objects;
+    remembered_.insert(remembered_.end(), other->remembered_.begin(), other->remembered_.end());
+    other->young_.clear();
+    other->old_.clear();
+    other->remembered_.clear();
+    for (size_t i = 0; i < HeapStats::kTypeCount; ++i) {
+        stats_.allocations[i] += other->stats_.allocations[i];
+    }
+    stats_.bytes_allocated += other->stats_.bytes_allocated;
+    stats_.objects_freed += other->stats_.objects_freed;
 }
 
-void Heap::Mark(Object* root) {
-    if (!root) {
+void Heap::Marker::Visit(Object* obj) {
+    if (!obj || IsImmediate(obj) || obj->generation_ == Generation::PERMANENT || obj->Marked()) {
+        return;
+    }
+    if (young_only_ && obj->generation_ != Generation::YOUNG) {
         return;
     }
-    if (used_.count(root)) {
+    obj->Mark();
+    heap_->mark_stack_.push_back(obj);
+}
+
+void Heap::Marker::Drain() {
+    std::vector<Object*>& stack = heap_->mark_stack_;
+    while (!stack.empty()) {
+        Object* cur = stack.back();
+        stack.pop_back();
+        cur->Trace(this);
+    }
+}
+
+void Heap::Destroy(Object* obj) {
+    ++stats_.objects_freed;
+    uint8_t size_class = obj->size_class_;
+    if (size_class == Arena::kUnpooled) {
+        delete obj;
         return;
     }
-    used_.insert(root);
-    root->Mark();
-    for (Object* nxt : root->Dep()) {
-        Mark(nxt);
+    obj->~Object();
+    arena_.Free(obj, size_class);
+}
+
+Object* Heap::MakeList(Object* const* items, size_t count, Object* tail) {
+    if (phase_ == Phase::SWEEPING) {
+        SweepSome(kLazySweepWork * count);
+    }
+    // Reserved up front, so a cell is appended as soon as it is built and a failed allocation
+    // leaves only complete cells behind.
+    if (young_.capacity() - young_.size() < count) {
+        young_.reserve(std::max(young_.size() + count, 2 * young_.capacity()));
     }
+    // Built back to front, each cell points at the already built rest of the list.
+    Object* next = tail;
+    size_t index = count;
+#ifdef SCHEME_HEAP_MALLOC
+    for (; index > 0; --index) {
+        Cell* cell = new Cell(items[index - 1], next);
+        cell->generation_ = Generation::YOUNG;
+        young_.push_back(cell);
+        next = cell;
+    }
+#else
+    uint8_t size_class = Arena::SizeClass(sizeof(Cell));
+    size_t slot_size = Arena::SlotSize(size_class);
+    while (index > 0) {
+        size_t run;
+        char* memory = static_cast<char*>(arena_.AllocateRun(size_class, index, &run));
+        // The last run slot gets the last cell, so the list goes forward in memory.
+        for (size_t i = run; i > 0; --i, --index) {
+            Cell* cell = new (memory + (i - 1) * slot_size) Cell(items[index - 1], next);
+            cell->size_class_ = size_class;
+            cell->generation_ = Generation::YOUNG;
+            young_.push_back(cell);
+            next = cell;
+        }
+    }
+#endif
+    stats_.allocations[static_cast<size_t>(TypeTag::CELL)] += count;
+    stats_.bytes_allocated += count * sizeof(Cell);
+    return next;
 }
 
+namespace {
+
+thread_local Heap* current_heap = nullptr;
+
+}  // namespace
+
 Heap& Hp() {
+    if (current_heap) {
+        return *current_heap;
+    }
     static Heap heap;
     return heap;
 }
 
+HeapBinding::HeapBinding(Heap* heap) : previous_(current_heap) {
+    current_heap = heap;
+}
+
+HeapBinding::~HeapBinding() {
+    current_heap = previous_;
+}
+
+namespace {
+
+constexpr int64_t kImmediateMin = -(int64_t{1} << 62);
+constexpr int64_t kImmediateMax = (int64_t{1} << 62) - 1;
+
+Boolean* MakePermanentBoolean(bool value) {
+    Boolean* obj = new Boolean(value);
+    Heap::MakePermanent(obj);
+    return obj;
+}
+
+}  // namespace
+
+const char* TypeTagName(TypeTag tag) {
+    switch (tag) {
+        case TypeTag::NUMBER:
+            return "number";
+        case TypeTag::BOOLEAN:
+            return "boolean";
+        case TypeTag::SYMBOL:
+            return "symbol";
+        case TypeTag::CELL:
+            return "cell";
+        case TypeTag::SCOPE:
+            return "scope";
+        case TypeTag::LOCAL_REF:
+            return "local-ref";
+        case TypeTag::CODE_BLOCK:
+            return "code-block";
+        case TypeTag::QUOTE:
+            return "quote";
+        case TypeTag::BOOLEAN_FORM:
+            return "boolean-form";
+        case TypeTag::IF:
+            return "if";
+        case TypeTag::DEFINE:
+            return "define";
+        case TypeTag::SET:
+            return "set";
+        case TypeTag::LAMBDA_MAKER:
+            return "lambda-maker";
+        case TypeTag::SPECIAL_FORM:
+            return "special-form";
+        case TypeTag::PRIMITIVE:
+            return "primitive";
+        case TypeTag::LAMBDA:
+            return "lambda";
+        case TypeTag::VM_CLOSURE:
+            return "vm-closure";
+    }
+    throw std::logic_error("unknown type tag");
+}
+
+Object* MakeNumber(int64_t value) {
+    if (value < kImmediateMin || kImmediateMax < value) {
+        return Hp().Make<Number>(value);
+    }
+    return reinterpret_cast<Object*>((static_cast<uintptr_t>(value) << 1) | 1);
+}
+
+int64_t GetNumber(Object* obj) {
+    if (IsImmediate(obj)) {
+        return static_cast<int64_t>(reinterpret_cast<uintptr_t>(obj)) >> 1;
+    }
+    return As<Number>(obj)->GetValue();
+}
+
+Object* MakeBoolean(bool value) {
+    static Boolean* const kValues[] = {MakePermanentBoolean(false), MakePermanentBoolean(true)};
+    return kValues[value];
+}
+
+Object* Evaluate(Object* obj, Object* scope) {
+    if (!obj) {
+        throw RuntimeError("can not evaluate empty list");
+    }
+    if (IsImmediate(obj)) {
+        return obj;
+    }
+    return obj->Eval(scope);
+}
+
+std::string SerializeObject(Object* obj) {
+    std::string res;
+    StringSink sink(&res);
+    WriteObject(obj, &sink);
+    return res;
+}
+
+namespace {
+
+// Lets the symbol table be searched with a string_view without building a std::string.
+struct NameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>()(name);
+    }
+};
+
+}  // namespace
+
+Symbol* Intern(std::string_view name) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::unique_ptr<Symbol>, NameHash, std::equal_to<>>
+        table;
+    std::lock_guard lock(mutex);
+    auto it = table.find(name);
+    if (it == table.end()) {
+        auto symbol = std::make_unique<Symbol>(std::string(name));
+        Heap::MakePermanent(symbol.get());
+        it = table.emplace(std::string(name), std::move(symbol)).first;
+    }
+    return it->second.get();
+}
+
 Object* Symbol::Eval(Object* scope) const {
     if (!Is<Scope>(scope)) {
         throw std::logic_error("Scope is not a scope in Symbol::Eval");
     }
-    if (!As<Scope>(scope)->Exists(name_)) {
+    Object** place = As<Scope>(scope)->FindPlace(this);
+    if (!place) {
         throw NameError("can not eval symbol: no such name " + name_);
     }
-    Object* me = As<Scope>(scope)->Find(name_);
-    return me;
+    return *place;
 }
 
-Object* Cell::Eval(Object* scope) const {
-    if (!first_) {
-        throw RuntimeError("cant recognize operator while evaluation");
-    }
-    Object* first_eval = first_->Eval(scope);
-    if (!Is<FunctionalObject>(first_eval)) {
-        throw RuntimeError("cant evaluate cell");
+Object* LocalRef::Eval(Object* scope) const {
+    if (!Is<Scope>(scope)) {
+        throw std::logic_error("Scope is not a scope in LocalRef::Eval");
     }
-    return As<FunctionalObject>(first_eval)->Calc(second_, scope);
+    return As<Scope>(scope)->Frame(depth_)->GetSlot(slot_);
 }
 
-std::string Cell::Serialize() const {
-    std::string res = "(";
-    Cell* cur = Hp().Make<Cell>(GetFirst(), GetSecond());
+Object* Cell::Eval(Object* scope) const {
+    const Cell* cell = this;
+    // Frame created by a tail call of this loop, nothing else refers to it unless captured.
+    Scope* owned = nullptr;
     while (true) {
-        if (!cur->GetFirst()) {
-            res += "()";
-        } else {
-            res += cur->GetFirst()->Serialize();
+        if (!cell->first_) {
+            throw RuntimeError("cant recognize operator while evaluation");
+        }
+        Object* first_eval = Evaluate(cell->first_, scope);
+        if (!Is<FunctionalObject>(first_eval)) {
+            throw RuntimeError("cant evaluate cell");
+        }
+        TailCall tail;
+        if (owned && owned == scope && !owned->Captured()) {
+            tail.spare = owned;
+        }
+        Object* ret = As<FunctionalObject>(first_eval)->TailCalc(cell->second_, scope, &tail);
+        if (!tail.scope) {
+            return ret;
         }
-        if (!cur->GetSecond()) {
-            break;
+        if (tail.scope != scope) {
+            owned = tail.scope;
+            scope = tail.scope;
         }
-        res += " ";
-        if (!Is<Cell>(cur->GetSecond())) {
-            res += ". " + cur->GetSecond()->Serialize();
-            break;
+        if (!Is<Cell>(tail.expr)) {
+            return Evaluate(tail.expr, scope);
         }
-        Cell* next = As<Cell>(cur->GetSecond());
-        cur = next;
+        cell = As<Cell>(tail.expr);
     }
-    return res + ")";
-}
\ No newline at end of file
+}
+
+std::string Cell::Serialize() const {
+    return SerializeObject(const_cast<Cell*>(this));
+}
@@ -1,20 +1,73 @@
 #pragma once
 
 #include "error.h"
+#include "arena.h"
 
 #include <memory>
+#include <new>
 #include <string>
+#include <string_view>
+#include <deque>
 #include <vector>
 #include <optional>
 #include <utility>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
-#include <set>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <type_traits>
 
-class Object : public std::enable_shared_from_this<Object> {
+// Objects created by Heap::Make start in the young generation and are promoted to the old one
+// once they survive a collection. Objects created outside of the heap are treated as old.
+// Permanent objects are shared constants: the collector never marks nor traces them.
+enum class Generation : uint8_t { YOUNG, OLD, PERMANENT };
+
+class Object;
+
+// Receives the outgoing references of an object, see Object::Trace.
+class Tracer {
+public:
+    virtual void Visit(Object* obj) = 0;
+
+protected:
+    ~Tracer() = default;
+};
+
+// Dynamic type of an object, checked by Is and As. Subclasses of a class tested with Is take
+// consecutive tags, so the test is a range check, see TypeTags below.
+enum class TypeTag : uint8_t {
+    NUMBER,
+    BOOLEAN,
+    SYMBOL,
+    CELL,
+    SCOPE,
+    LOCAL_REF,
+    CODE_BLOCK,
+    // Special forms.
+    QUOTE,
+    BOOLEAN_FORM,
+    IF,
+    DEFINE,
+    SET,
+    LAMBDA_MAKER,
+    SPECIAL_FORM,
+    // Procedures.
+    PRIMITIVE,
+    LAMBDA,
+    VM_CLOSURE,
+};
+
+// Lowercase name of a type tag, as reported by (gc-stats).
+const char* TypeTagName(TypeTag tag);
+
+class Object {
 public:
     Object(const Object& other) = delete;
-    Object() = default;
+    explicit Object(TypeTag tag) : tag_(tag) {
+    }
     virtual ~Object() = default;
     virtual Object* Eval(Object*) const = 0;
     virtual std::string Serialize() const = 0;
@@ -28,75 +81,292 @@ public:
     bool Marked() const {
         return marked_;
     }
-    void AddDep(Object* other) {
-        dep_.push_back(other);
+    Generation GetGeneration() const {
+        return generation_;
     }
-    void RmDep(Object* other) {
-        auto it = std::find(dep_.begin(), dep_.end(), other);
-        if (it != dep_.end()) {
-            dep_.erase(it);
-        }
+    TypeTag GetTag() const {
+        return tag_;
     }
-    const std::vector<Object*>& Dep() const {
-        return dep_;
+    // Reports every object directly referenced by this one to the tracer.
+    virtual void Trace(Tracer*) const {
     }
 
 private:
-    bool marked_;
-    std::vector<Object*> dep_;
+    friend class Heap;
+
+    TypeTag tag_;
+    bool marked_ = false;
+    bool remembered_ = false;
+    Generation generation_ = Generation::OLD;
+    uint8_t size_class_ = Arena::kUnpooled;
 };
 
+// Immediate values.
+// Small integers are not allocated at all: the value is stored in the pointer itself as
+// (value << 1) | 1. Such pointers must never be dereferenced, see MakeNumber and GetNumber below.
+
+inline bool IsImmediate(const Object* obj) {
+    return reinterpret_cast<uintptr_t>(obj) & 1;
+}
+
 class Scope;
 
+// Counters of a heap, see Heap::GetStats. They are plain fields updated by the thread owning the
+// heap, cheap enough to be always on.
+struct HeapStats {
+    static constexpr size_t kTypeCount = static_cast<size_t>(TypeTag::VM_CLOSURE) + 1;
+
+    // Objects made by the heap by TypeTag, and their sizes without the memory owned by their
+    // members.
+    std::array<uint64_t, kTypeCount> allocations{};
+    uint64_t bytes_allocated = 0;
+    uint64_t objects_freed = 0;
+
+    uint64_t minor_collections = 0;
+    // Finished collections of the old generation, incremental or not.
+    uint64_t major_collections = 0;
+    // Nursery objects seen by minor collections and the survivors among them, in total and in
+    // the last one.
+    uint64_t young_collected = 0;
+    uint64_t young_promoted = 0;
+    size_t last_young_collected = 0;
+    size_t last_young_promoted = 0;
+
+    // Time spent in CleanUp and CleanUpFull calls.
+    std::chrono::nanoseconds last_pause{0};
+    std::chrono::nanoseconds max_pause{0};
+    std::chrono::nanoseconds total_pause{0};
+    // Parts of the pauses spent marking and sweeping the old generation. The sweeping done by
+    // allocations is not timed.
+    std::chrono::nanoseconds mark_time{0};
+    std::chrono::nanoseconds sweep_time{0};
+
+    // Objects in the heap when the stats were taken, swept garbage excluded, and the old objects
+    // left by the last major collection.
+    size_t young_objects = 0;
+    size_t old_objects = 0;
+    size_t live_after_major = 0;
+};
+
+// Define SCHEME_HEAP_MALLOC to allocate every object with the global new/delete instead of the
+// size-class arena (useful for comparing both allocators).
+
 class Heap {
 public:
     template <typename T, typename... Args>
     T* Make(Args&&... args) {
+        if (phase_ == Phase::SWEEPING) {
+            SweepSome(kLazySweepWork);
+        }
+#ifdef SCHEME_HEAP_MALLOC
         T* x = new T(std::forward<Args>(args)...);
-        objects_.push_back(dynamic_cast<Object*>(x));
+#else
+        uint8_t size_class = Arena::SizeClass(sizeof(T));
+        T* x;
+        if (size_class == Arena::kUnpooled) {
+            x = new T(std::forward<Args>(args)...);
+        } else {
+            void* memory = arena_.Allocate(size_class);
+            try {
+                x = new (memory) T(std::forward<Args>(args)...);
+            } catch (...) {
+                arena_.Free(memory, size_class);
+                throw;
+            }
+            x->size_class_ = size_class;
+        }
+#endif
+        x->generation_ = Generation::YOUNG;
+        young_.push_back(x);
+        ++stats_.allocations[static_cast<size_t>(x->tag_)];
+        stats_.bytes_allocated += sizeof(T);
         return x;
     }
     template <typename T>
     T* Clone(T* ptr) {
-        if (!Is<Object>(ptr)) {
-            throw std::logic_error("In clone method Object is not base of ptr");
-        }
-        T* copy = As<T>(As<Object>(ptr)->AllocateCopy());
-        objects_.push_back(copy);
-        return copy;
+        return static_cast<T*>(static_cast<Object*>(ptr)->AllocateCopy());
     }
-    ~Heap() {
-        for (Object* alive : objects_) {
-            if (alive) {
-                delete alive;
-            }
+    Heap() = default;
+    Heap(const Heap& other) = delete;
+    ~Heap();
+
+    // Must be called before a pointer to value is stored into owner after construction.
+    // Remembers old objects pointing into the nursery, they are the extra roots of a minor
+    // collection, and shades value while an incremental cycle is marking, so a black object
+    // never points to a white one.
+    void WriteBarrier(Object* owner, Object* value) {
+        if (value && !IsImmediate(value) && value->generation_ == Generation::YOUNG &&
+            owner->generation_ == Generation::OLD && !owner->remembered_) {
+            owner->remembered_ = true;
+            remembered_.push_back(owner);
+        }
+        if (phase_ == Phase::MARKING) {
+            Shade(value);
         }
     }
+
+    // Collects the nursery and promotes its survivors. The old generation is collected only
+    // when it has grown past the threshold left by the previous full collection: marked at
+    // once, by several threads on large heaps, or by an incremental cycle which does a slice of
+    // its work in every call, see SetPauseBudget. Either way the dead objects are swept lazily,
+    // by the following calls and by the allocations, which reuse their memory.
     void CleanUp(Object* root);
+    // Collects both generations, finishing the incremental cycle in progress first.
+    void CleanUpFull(Object* root);
+
+    // Time spent on the old generation per CleanUp call. Zero, the default, collects it in a
+    // single pause. A slice may overrun the budget by the tracing or sweeping of a few hundred
+    // objects, and a cycle which falls behind the allocation is finished at once.
+    void SetPauseBudget(std::chrono::microseconds budget) {
+        pause_budget_ = budget;
+    }
+    std::chrono::microseconds GetPauseBudget() const {
+        return pause_budget_;
+    }
+
+    HeapStats GetStats() const;
+    // Called with the stats after every CleanUp and CleanUpFull call, nullptr for none. The
+    // callback must not use the heap.
+    using CollectionCallback = std::function<void(const HeapStats&)>;
+    void SetCollectionCallback(CollectionCallback callback) {
+        on_collection_ = std::move(callback);
+    }
+    const CollectionCallback& GetCollectionCallback() const {
+        return on_collection_;
+    }
+
+    // Builds the list items[0], ..., items[count - 1] ending with tail. The cells are allocated
+    // as one block and registered with the heap at once. Returns tail if count is 0.
+    Object* MakeList(Object* const* items, size_t count, Object* tail = nullptr);
+
+    static void MakePermanent(Object* obj) {
+        obj->generation_ = Generation::PERMANENT;
+    }
+
+    // Takes over the objects and the memory of other, which must not be in use by any thread.
+    void Absorb(Heap* other);
 
 private:
-    void Mark(Object* root);
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kMinOldThreshold = 1 << 16;
+    // Objects traced or swept between two clock reads of a slice.
+    static constexpr size_t kSliceWork = 256;
+    // Objects swept by every allocation while a sweep is pending.
+    static constexpr size_t kLazySweepWork = 16;
+    // Old objects from which a full marking uses all cores.
+    static constexpr size_t kParallelMarkThreshold = 1 << 17;
+
+    // Incremental collection of the old generation.
+    // Tri-color marking: white objects are not marked, gray ones are marked and wait in gray_
+    // to be traced, black ones are marked and traced. A cycle shades the root and traces gray
+    // objects slice by slice; the write barrier shades every value stored meanwhile and the
+    // objects promoted meanwhile are shaded, as the pointers they got at construction passed no
+    // barrier. Once no gray object is left, the white objects are garbage and are swept slice
+    // by slice and by the allocations, while objects promoted meanwhile are appended behind the
+    // swept range. A full marking by CollectOld leaves its sweep pending the same way.
+    // Marking slices run only in CleanUp calls, when the nursery is empty.
+    enum class Phase : uint8_t { IDLE, MARKING, SWEEPING };
 
-    std::vector<Object*> objects_;
-    std::set<Object*> used_;
+    void Shade(Object* obj) {
+        if (obj && !IsImmediate(obj) && obj->generation_ == Generation::OLD && !obj->marked_) {
+            obj->marked_ = true;
+            gray_.push_back(obj);
+        }
+    }
+    void StartCycle(Object* root);
+    // Works on the cycle until it ends or the deadline passes.
+    void Step(Clock::time_point deadline);
+    // Returns true once no gray object is left.
+    bool MarkSome(Clock::time_point deadline);
+    void StartSweep();
+    // Sweeps up to count objects and ends the cycle once all are swept.
+    void SweepSome(size_t count);
+    void FinishCycle() {
+        Step(Clock::time_point::max());
+    }
+
+    void CollectYoung(Object* root);
+    void CollectOld(Object* root);
+    // Accounts for a CleanUp or CleanUpFull call which started at start.
+    void EndPause(Clock::time_point start);
+    class Marker : public Tracer {
+    public:
+        Marker(Heap* heap, bool young_only) : heap_(heap), young_only_(young_only) {
+        }
+        void Visit(Object* obj) override;
+        void Drain();
+
+    private:
+        Heap* heap_;
+        bool young_only_;
+    };
+    class ParallelMarker;
+    class Shader : public Tracer {
+    public:
+        explicit Shader(Heap* heap) : heap_(heap) {
+        }
+        void Visit(Object* obj) override {
+            heap_->Shade(obj);
+        }
+
+    private:
+        Heap* heap_;
+    };
+
+    void Destroy(Object* obj);
+
+    Arena arena_;
+    std::vector<Object*> young_;
+    // A deque, so promotions never copy the whole old generation within a pause.
+    std::deque<Object*> old_;
+    std::vector<Object*> remembered_;
+    std::vector<Object*> mark_stack_;
+    size_t old_threshold_ = kMinOldThreshold;
+
+    std::chrono::microseconds pause_budget_{0};
+    Phase phase_ = Phase::IDLE;
+    std::vector<Object*> gray_;
+    // While sweeping, old_[0, swept_alive_) holds the survivors swept so far, old_[sweep_index_,
+    // sweep_end_) the objects left to sweep and old_[sweep_end_, ...) the promoted ones.
+    size_t swept_alive_ = 0;
+    size_t sweep_index_ = 0;
+    size_t sweep_end_ = 0;
+
+    HeapStats stats_;
+    CollectionCallback on_collection_;
 };
 
+// Heap of the calling thread: the heap bound by the innermost live HeapBinding, or the heap
+// shared by the code running outside of any binding.
 Heap& Hp();
 
+// Makes Hp() return heap on the calling thread until destroyed. Every interpreter binds its own
+// heap while it runs, so interpreters never share a heap and may run on different threads.
+class HeapBinding {
+public:
+    explicit HeapBinding(Heap* heap);
+    HeapBinding(const HeapBinding& other) = delete;
+    ~HeapBinding();
+
+private:
+    Heap* previous_;
+};
+
 class Number : public Object {
 public:
-    explicit Number(int64_t value) : value_{value} {};
+    explicit Number(int64_t value) : Object(TypeTag::NUMBER), value_{value} {};
     int64_t GetValue() const {
         return value_.x;
     }
     Object* Eval(Object*) const override {
-        return Hp().Make<Number>(value_.x);
+        return const_cast<Number*>(this);
     }
     std::string Serialize() const override {
         return std::to_string(value_.x);
     }
     Object* AllocateCopy() const override {
-        return new Number(value_.x);
+        return Hp().Make<Number>(value_.x);
     }
 
 private:
@@ -107,18 +377,18 @@ private:
 
 class Boolean : public Object {
 public:
-    explicit Boolean(bool value) : value_{value} {};
+    explicit Boolean(bool value) : Object(TypeTag::BOOLEAN), value_{value} {};
     bool GetValue() const {
         return value_.x;
     }
     Object* Eval(Object*) const override {
-        return Hp().Make<Boolean>(value_.x);
+        return const_cast<Boolean*>(this);
     }
     std::string Serialize() const override {
         return value_.x ? "#t" : "#f";
     }
     Object* AllocateCopy() const override {
-        return new Boolean(value_.x);
+        return Hp().Make<Boolean>(value_.x);
     }
 
 private:
@@ -127,9 +397,11 @@ private:
     } value_;
 };
 
+// Symbols are interned: every distinct name is a single permanent object, so symbols and
+// scope keys are compared by pointer. Use Intern to obtain one.
 class Symbol : public Object {
 public:
-    Symbol(const std::string name) : name_(name) {
+    explicit Symbol(const std::string& name) : Object(TypeTag::SYMBOL), name_(name) {
     }
     const std::string& GetName() const {
         return name_;
@@ -139,19 +411,19 @@ public:
         return name_;
     }
     Object* AllocateCopy() const override {
-        return new Symbol(name_);
+        return const_cast<Symbol*>(this);
     }
 
 private:
     std::string name_;
 };
 
+Symbol* Intern(std::string_view name);
+
 class Cell : public Object {
 public:
-    Cell(Object* first, Object* second = nullptr) : first_(first), second_(second) {
-        AddDep(first_);
-        AddDep(second_);
-    };
+    Cell(Object* first, Object* second = nullptr)
+        : Object(TypeTag::CELL), first_(first), second_(second){};
     Object* GetFirst() const {
         return first_;
     }
@@ -159,19 +431,21 @@ public:
         return second_;
     }
     void SetFirst(Object* ptr) {
-        RmDep(first_);
+        Hp().WriteBarrier(this, ptr);
         first_ = ptr;
-        AddDep(first_);
     }
     void SetSecond(Object* ptr) {
-        RmDep(second_);
+        Hp().WriteBarrier(this, ptr);
         second_ = ptr;
-        AddDep(second_);
     }
     Object* Eval(Object* scope) const override;
     std::string Serialize() const override;
     Object* AllocateCopy() const override {
-        return new Cell(first_, second_);
+        return Hp().Make<Cell>(first_, second_);
+    }
+    void Trace(Tracer* tracer) const override {
+        tracer->Visit(first_);
+        tracer->Visit(second_);
     }
 
 private:
@@ -179,6 +453,22 @@ private:
     Object* second_;
 };
 
+// Layout of a lambda call frame.
+// Arguments live in a flat vector of slots and are addressed by index. Names introduced by
+// define inside the body are dynamic: they are stored by name and always looked up by name.
+struct FrameLayout {
+    std::vector<const Symbol*> slots;
+    std::unordered_set<const Symbol*> dynamic;
+
+    std::optional<size_t> Slot(const Symbol* name) const {
+        auto it = std::find(slots.begin(), slots.end(), name);
+        if (it == slots.end()) {
+            return std::nullopt;
+        }
+        return it - slots.begin();
+    }
+};
+
 class Scope : public Object {
 public:
     Object* Eval(Object*) const override {
@@ -187,64 +477,172 @@ public:
     std::string Serialize() const override {
         throw std::logic_error("Can not serialize scope object");
     }
-    Scope(const std::map<std::string, Object*>& variables = {})
-        : variables_(variables), parent_(nullptr) {
-        for (auto [str, var] : variables_) {
-            AddDep(var);
-        }
-        AddDep(parent_);
+    Scope(Scope* parent = nullptr) : Object(TypeTag::SCOPE), parent_(parent) {
     }
-    Scope(const std::map<std::string, Object*>& variables, Scope* parent)
-        : variables_(variables), parent_(parent) {
-        for (auto [str, var] : variables_) {
-            AddDep(var);
+    Scope(Scope* parent, std::shared_ptr<const FrameLayout> layout)
+        : Object(TypeTag::SCOPE),
+          parent_(parent),
+          layout_(std::move(layout)),
+          slot_count_(layout_->slots.size()) {
+        if (slot_count_ > kInlineSlots) {
+            spilled_slots_.resize(slot_count_);
         }
-        AddDep(parent_);
     }
-    Scope(Scope* parent) : parent_(parent) {
-        AddDep(parent_);
+    Object* Find(const Symbol* name) {
+        Object** place = FindPlace(name);
+        return place ? *place : nullptr;
     }
-    Object* Find(const std::string& name) {
-        if (variables_.contains(name)) {
-            return variables_[name];
-        }
-        return parent_ ? parent_->Find(name) : nullptr;
+    bool Exists(const Symbol* name) {
+        return FindPlace(name) != nullptr;
     }
-    bool Exists(const std::string& name) const {
-        if (variables_.contains(name)) {
-            return true;
+    // Returns the storage of the nearest binding of name, nullptr if there is none.
+    Object** FindPlace(const Symbol* name) {
+        for (Scope* cur = this; cur; cur = cur->parent_) {
+            if (Object** place = cur->LocalPlace(name)) {
+                return place;
+            }
         }
-        return parent_ && parent_->Exists(name);
+        return nullptr;
     }
-    void Set(const std::string& name, Object* value) {
+    void Set(const Symbol* name, Object* value) {
         if (!Exists(name)) {
-            throw NameError("cant recognize name " + name);
+            throw NameError("cant recognize name " + name->GetName());
         }
         SetForce(name, value);
     }
-    void Define(const std::string& name, Object* value) {
-        variables_[name] = value;
-        AddDep(value);
+    void Define(const Symbol* name, Object* value) {
+        Hp().WriteBarrier(this, value);
+        if (Object** place = LocalPlace(name)) {
+            *place = value;
+        } else {
+            variables_[name] = value;
+        }
+    }
+    Scope* GetParent() const {
+        return parent_;
+    }
+    const FrameLayout* GetLayout() const {
+        return layout_.get();
+    }
+    // Names bound by define, argument slots are not included.
+    const std::unordered_map<const Symbol*, Object*>& GetVariables() const {
+        return variables_;
+    }
+    // Frame depth levels above this one.
+    Scope* Frame(size_t depth) {
+        Scope* cur = this;
+        for (; depth > 0; --depth) {
+            cur = cur->parent_;
+        }
+        return cur;
+    }
+    Object* GetSlot(size_t slot) const {
+        return Slots()[slot];
+    }
+    void SetSlot(size_t slot, Object* value) {
+        Hp().WriteBarrier(this, value);
+        Slots()[slot] = value;
+    }
+    // A frame is captured once a closure is created over it. A closure may then reach it after
+    // the call returns, so a captured frame must never be reused as a TailCall::spare.
+    void MarkCaptured() {
+        captured_ = true;
+    }
+    bool Captured() const {
+        return captured_;
+    }
+    // Prepares a frame which was not captured for another call of the same lambda.
+    void Recycle() {
+        variables_.clear();
     }
     Object* AllocateCopy() const override {
-        return new Scope(variables_, parent_);
+        Scope* copy = Hp().Make<Scope>(parent_);
+        copy->variables_ = variables_;
+        copy->layout_ = layout_;
+        copy->inline_slots_ = inline_slots_;
+        copy->spilled_slots_ = spilled_slots_;
+        copy->slot_count_ = slot_count_;
+        copy->captured_ = captured_;
+        return copy;
+    }
+    void Trace(Tracer* tracer) const override {
+        for (size_t i = 0; i < slot_count_; ++i) {
+            tracer->Visit(Slots()[i]);
+        }
+        for (const auto& [name, value] : variables_) {
+            tracer->Visit(value);
+        }
+        tracer->Visit(parent_);
     }
 
 private:
-    void SetForce(const std::string& name, Object* value) {
-        if (variables_.contains(name)) {
-            RmDep(variables_[name]);
-            variables_[name] = value;
-            AddDep(value);
-        } else if (parent_) {
-            parent_->SetForce(name, value);
-        } else {
-            throw std::logic_error(
-                "scope: set force: current scope variables not contain name and parent is null");
+    Object** LocalPlace(const Symbol* name) {
+        if (layout_) {
+            if (auto slot = layout_->Slot(name)) {
+                return &Slots()[*slot];
+            }
+        }
+        auto it = variables_.find(name);
+        return it == variables_.end() ? nullptr : &it->second;
+    }
+    void SetForce(const Symbol* name, Object* value) {
+        for (Scope* cur = this; cur; cur = cur->parent_) {
+            if (Object** place = cur->LocalPlace(name)) {
+                Hp().WriteBarrier(cur, value);
+                *place = value;
+                return;
+            }
         }
+        throw std::logic_error(
+            "scope: set force: current scope variables not contain name and parent is null");
     }
-    std::map<std::string, Object*> variables_;
+    Object* const* Slots() const {
+        return slot_count_ > kInlineSlots ? spilled_slots_.data() : inline_slots_.data();
+    }
+    Object** Slots() {
+        return slot_count_ > kInlineSlots ? spilled_slots_.data() : inline_slots_.data();
+    }
+
+    // Frames of lambdas with few arguments keep their slots inline and cost no extra allocation.
+    static constexpr size_t kInlineSlots = 4;
+
+    std::unordered_map<const Symbol*, Object*> variables_;
     Scope* parent_;
+    std::shared_ptr<const FrameLayout> layout_;
+    std::array<Object*, kInlineSlots> inline_slots_{};
+    std::vector<Object*> spilled_slots_;
+    size_t slot_count_ = 0;
+    bool captured_ = false;
+};
+
+// Reference to a lambda argument resolved at lambda creation: the slot in the frame depth
+// levels above the current one. Evaluates without any name lookup.
+class LocalRef : public Object {
+public:
+    LocalRef(Symbol* name, size_t depth, size_t slot)
+        : Object(TypeTag::LOCAL_REF), name_(name), depth_(depth), slot_(slot) {
+    }
+    Symbol* GetName() const {
+        return name_;
+    }
+    size_t GetDepth() const {
+        return depth_;
+    }
+    size_t GetSlot() const {
+        return slot_;
+    }
+    Object* Eval(Object* scope) const override;
+    std::string Serialize() const override {
+        return name_->GetName();
+    }
+    Object* AllocateCopy() const override {
+        return Hp().Make<LocalRef>(name_, depth_, slot_);
+    }
+
+private:
+    Symbol* name_;
+    size_t depth_;
+    size_t slot_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -252,12 +650,60 @@ private:
 // Runtime type checking and convertion.
 // This can be helpful: https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
 
+// Tags of T and its subclasses. Only classes with a TypeTags specialization can be used with Is
+// and As.
 template <class T>
-T* As(Object* obj) noexcept {
-    return dynamic_cast<T*>(obj);
-}
+struct TypeTags;
+
+template <TypeTag First, TypeTag Last = First>
+struct TagRange {
+    static bool Contains(TypeTag tag) {
+        return First <= tag && tag <= Last;
+    }
+};
+
+template <>
+struct TypeTags<Number> : TagRange<TypeTag::NUMBER> {};
+template <>
+struct TypeTags<Boolean> : TagRange<TypeTag::BOOLEAN> {};
+template <>
+struct TypeTags<Symbol> : TagRange<TypeTag::SYMBOL> {};
+template <>
+struct TypeTags<Cell> : TagRange<TypeTag::CELL> {};
+template <>
+struct TypeTags<Scope> : TagRange<TypeTag::SCOPE> {};
+template <>
+struct TypeTags<LocalRef> : TagRange<TypeTag::LOCAL_REF> {};
 
 template <class T>
 bool Is(Object* obj) {
-    return As<T>(obj) != nullptr;
+    if (IsImmediate(obj)) {
+        return std::is_base_of_v<T, Number>;
+    }
+    return obj && TypeTags<T>::Contains(obj->GetTag());
+}
+
+template <class T>
+T* As(Object* obj) noexcept {
+    if (IsImmediate(obj) || !Is<T>(obj)) {
+        return nullptr;
+    }
+    return static_cast<T*>(obj);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Value helpers aware of immediates.
+// Numbers must be read with GetNumber: As<Number> fails on an immediate.
+
+// Returns an immediate when the value fits, a heap Number otherwise.
+Object* MakeNumber(int64_t value);
+
+int64_t GetNumber(Object* obj);
+
+// #t and #f are two permanent objects, so producing a boolean never allocates.
+Object* MakeBoolean(bool value);
+
+Object* Evaluate(Object* obj, Object* scope);
+
+std::string SerializeObject(Object* obj);
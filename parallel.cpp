@@ -0,0 +1,122 @@
+#include "parallel.h"
+
+#include "object.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <optional>
+
+namespace {
+
+// Chunks per pool worker, more even out calls of different cost.
+constexpr size_t kChunksPerWorker = 4;
+
+ThreadPool& SharedPool() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+// Shared by the loop and its helper tasks, which may start after the loop is done.
+struct LoopState {
+    size_t count;
+    size_t chunk_size;
+    size_t chunk_count;
+    const std::function<void(size_t)>* body;
+    bool own_heaps;
+
+    std::atomic<size_t> next_chunk = 0;
+    std::atomic<bool> failed = false;
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t finished_chunks = 0;
+    std::exception_ptr error;
+    std::vector<std::unique_ptr<Heap>> heaps;
+
+    bool Claim(size_t* chunk) {
+        *chunk = next_chunk++;
+        return *chunk < chunk_count;
+    }
+
+    void RunChunk(size_t chunk) {
+        if (!failed) {
+            try {
+                size_t end = std::min(count, (chunk + 1) * chunk_size);
+                for (size_t i = chunk * chunk_size; i < end; ++i) {
+                    (*body)(i);
+                }
+            } catch (...) {
+                std::lock_guard lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+        std::lock_guard lock(mutex);
+        if (++finished_chunks == chunk_count) {
+            done.notify_all();
+        }
+    }
+};
+
+void Help(const std::shared_ptr<LoopState>& state) {
+    size_t chunk;
+    if (!state->Claim(&chunk)) {
+        return;
+    }
+    std::optional<HeapBinding> binding;
+    if (state->own_heaps) {
+        std::lock_guard lock(state->mutex);
+        state->heaps.push_back(std::make_unique<Heap>());
+        binding.emplace(state->heaps.back().get());
+    }
+    do {
+        state->RunChunk(chunk);
+    } while (state->Claim(&chunk));
+}
+
+void Run(size_t count, const std::function<void(size_t)>& body, bool own_heaps) {
+    ThreadPool& pool = SharedPool();
+    size_t chunk_count = std::min(count, pool.Size() * kChunksPerWorker);
+    if (chunk_count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+    auto state = std::make_shared<LoopState>();
+    state->count = count;
+    state->chunk_size = (count + chunk_count - 1) / chunk_count;
+    state->chunk_count = (count + state->chunk_size - 1) / state->chunk_size;
+    state->body = &body;
+    state->own_heaps = own_heaps;
+
+    std::vector<ThreadPool::Task> tasks(std::min(pool.Size(), state->chunk_count - 1),
+                                        [state](size_t) { Help(state); });
+    pool.Submit(std::move(tasks));
+    // The calling thread works as well, so the loop ends even if every worker is busy.
+    size_t chunk;
+    while (state->Claim(&chunk)) {
+        state->RunChunk(chunk);
+    }
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->finished_chunks == state->chunk_count; });
+    for (const auto& heap : state->heaps) {
+        Hp().Absorb(heap.get());
+    }
+    state->heaps.clear();
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+}  // namespace
+
+void ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+    Run(count, body, true);
+}
+
+void ParallelRun(size_t count, const std::function<void(size_t)>& body) {
+    Run(count, body, false);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/// Parallel loops over the evaluation of pure code.
+/// The calls made on pool threads allocate into heaps of their own. These heaps are merged into
+/// the heap of the calling thread before the loop returns, so the objects made by the calls are
+/// collected as usual afterwards. The calls may read any object, but must not change objects
+/// shared with other calls: nothing is collected before the loop ends and nothing is locked.
+
+// Calls body(i) for every i < count on a process-wide thread pool and on the calling thread.
+// The first exception thrown by body is rethrown once all the calls are done; the calls not
+// started by then are skipped.
+void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+// Like ParallelFor, for loops which do not allocate objects: the calls on pool threads get no
+// heaps of their own.
+void ParallelRun(size_t count, const std::function<void(size_t)>& body);
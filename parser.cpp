@@ -1,93 +1,166 @@
 #include "parser.h"
 
-Object* Read(Tokenizer* tokenizer) {
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("there is no tokens to read");
-    }
-    Token current_token = tokenizer->GetToken();
-    tokenizer->Next();
-    if (current_token == Token{QuoteToken()}) {
-        return ReadAfterQuote(tokenizer);
-    } else if (current_token == Token{BracketToken::OPEN}) {
-        return ReadList(tokenizer);
-    } else if (current_token == Token{BracketToken::CLOSE}) {
-        throw SyntaxError("unmatched close bracket");
-    } else if (std::holds_alternative<ConstantToken>(current_token)) {
-        return Hp().Make<Number>(std::get<ConstantToken>(current_token).value);
-    } else if (std::holds_alternative<SymbolToken>(current_token)) {
-        return Hp().Make<Symbol>(std::get<SymbolToken>(current_token).name);
-    } else if (current_token == Token{DotToken()}) {
-        throw SyntaxError("dot can not be outside of list");
-    } else if (std::holds_alternative<BooleanToken>(current_token)) {
-        return Hp().Make<Boolean>(std::get<BooleanToken>(current_token).value);
-    } else {
-        throw SyntaxError("unsupported token, may be tokenizer broken?");
-    }
-}
+namespace {
 
-Object* ReadAfterQuote(Tokenizer* tokenizer) {
-    Cell* first_cell_ptr = Hp().Make<Cell>(Hp().Make<Symbol>("quote"));
-    Object* read_object = Read(tokenizer);
-    Cell* next_cell_ptr = Hp().Make<Cell>(nullptr);
-    next_cell_ptr->SetFirst(read_object);
-    first_cell_ptr->SetSecond(next_cell_ptr);
-    return first_cell_ptr;
+Symbol* const kQuote = Intern("quote");
+
+bool StartsDatum(const Token& token) {
+    return std::holds_alternative<ConstantToken>(token) ||
+           std::holds_alternative<SymbolToken>(token) ||
+           std::holds_alternative<BooleanToken>(token) || token == Token{BracketToken::OPEN} ||
+           token == Token{QuoteToken()};
 }
 
-Object* ReadList(Tokenizer* tokenizer) {
-    Cell* first_cell_ptr = Hp().Make<Cell>(nullptr);
-    Cell* current_cell_ptr(first_cell_ptr);
+// Reads with an explicit stack instead of recursion, so the nesting depth of the input is not
+// limited by the C++ stack.
+class Reader {
+public:
+    explicit Reader(Tokenizer* tokenizer) : tokenizer_(tokenizer) {
+    }
 
-    bool meet_dot = false;
-    bool meet_last_after_dot = false;
-    bool read_at_least_one = false;
+    // Unfinished forms the reader starts inside of, as if their opening token was just read.
+    void OpenList() {
+        frames_.push_back(Frame{false, items_.size()});
+    }
+    void OpenQuote() {
+        frames_.push_back(Frame{true, items_.size()});
+    }
 
-    while (true) {
-        if (tokenizer->IsEnd()) {
-            throw SyntaxError("unmatched open bracket");
+    Object* Run() {
+        while (true) {
+            Object* value;
+            if (!frames_.empty() && !frames_.back().quote) {
+                if (!ListStep(&value)) {
+                    continue;
+                }
+            } else if (!ReadDatum(&value)) {
+                continue;
+            }
+            while (!frames_.empty() && frames_.back().quote) {
+                frames_.pop_back();
+                Object* items[] = {kQuote, value};
+                value = Hp().MakeList(items, 2);
+            }
+            if (frames_.empty()) {
+                return value;
+            }
+            Frame& list = frames_.back();
+            if (list.meet_dot) {
+                list.meet_last_after_dot = true;
+                list.tail = value;
+            } else {
+                items_.push_back(value);
+            }
         }
+    }
 
-        if (tokenizer->GetToken() == Token{BracketToken::CLOSE}) {
-            tokenizer->Next();
-            if (!read_at_least_one) {
-                return nullptr;
-            }
-            break;
+private:
+    // A list being read or a quote waiting for its datum.
+    struct Frame {
+        bool quote;
+        // Start of the list elements in items_.
+        size_t first;
+        Object* tail = nullptr;
+        bool meet_dot = false;
+        bool meet_last_after_dot = false;
+    };
+
+    // Reads the start of a datum. Returns false if it opened a list or a quote, which the
+    // following steps complete.
+    bool ReadDatum(Object** value) {
+        if (tokenizer_->IsEnd()) {
+            throw SyntaxError("there is no tokens to read");
+        }
+        Token current_token = tokenizer_->GetToken();
+        if (std::holds_alternative<SymbolToken>(current_token)) {
+            // The name may not outlive the next token.
+            *value = Intern(std::get<SymbolToken>(current_token).name);
+            tokenizer_->Next();
+            return true;
         }
+        tokenizer_->Next();
+        if (current_token == Token{QuoteToken()}) {
+            OpenQuote();
+            return false;
+        } else if (current_token == Token{BracketToken::OPEN}) {
+            OpenList();
+            return false;
+        } else if (current_token == Token{BracketToken::CLOSE}) {
+            throw SyntaxError("unmatched close bracket");
+        } else if (std::holds_alternative<ConstantToken>(current_token)) {
+            *value = MakeNumber(std::get<ConstantToken>(current_token).value);
+        } else if (current_token == Token{DotToken()}) {
+            throw SyntaxError("dot can not be outside of list");
+        } else if (std::holds_alternative<BooleanToken>(current_token)) {
+            *value = MakeBoolean(std::get<BooleanToken>(current_token).value);
+        } else {
+            throw SyntaxError("unsupported token, may be tokenizer broken?");
+        }
+        return true;
+    }
 
-        if (tokenizer->GetToken() == Token{DotToken()}) {
-            if (!current_cell_ptr->GetFirst()) {
+    // Handles the next token inside the innermost list. Returns true with the list once it is
+    // closed.
+    bool ListStep(Object** value) {
+        Frame& list = frames_.back();
+        if (tokenizer_->IsEnd()) {
+            throw SyntaxError("unmatched open bracket");
+        }
+        Token token = tokenizer_->GetToken();
+        if (token == Token{BracketToken::CLOSE}) {
+            tokenizer_->Next();
+            *value = CloseList();
+            return true;
+        }
+        if (token == Token{DotToken()}) {
+            if (items_.size() == list.first || !items_.back()) {
                 throw SyntaxError("there is nothing before dot in the list");
             }
-            meet_dot = true;
-            tokenizer->Next();
-        } else if (meet_last_after_dot) {
+            list.meet_dot = true;
+            tokenizer_->Next();
+            return false;
+        } else if (list.meet_last_after_dot) {
             throw SyntaxError("there should be close bracket after element next to dot");
-        } else if (std::holds_alternative<ConstantToken>(tokenizer->GetToken()) ||
-                   std::holds_alternative<SymbolToken>(tokenizer->GetToken()) ||
-                   std::holds_alternative<BooleanToken>(tokenizer->GetToken()) ||
-                   tokenizer->GetToken() == Token{BracketToken::OPEN} ||
-                   tokenizer->GetToken() == Token{QuoteToken()}) {
-            if (meet_dot) {
-                meet_last_after_dot = true;
-                current_cell_ptr->SetSecond(Read(tokenizer));
-            } else {
-                if (read_at_least_one) {
-                    Cell* new_cell_ptr = Hp().Make<Cell>(nullptr);
-                    current_cell_ptr->SetSecond(new_cell_ptr);
-                    current_cell_ptr = new_cell_ptr;
-                }
-                current_cell_ptr->SetFirst(Read(tokenizer));
-            }
+        } else if (StartsDatum(token)) {
+            return ReadDatum(value);
         } else {
             throw SyntaxError("unsupported token, may be tokenizer broken?");
         }
-        read_at_least_one = true;
     }
 
-    if (meet_dot && !meet_last_after_dot) {
-        throw SyntaxError("did not meet token after dot");
+    Object* CloseList() {
+        Frame& list = frames_.back();
+        if (list.meet_dot && !list.meet_last_after_dot) {
+            throw SyntaxError("did not meet token after dot");
+        }
+        // The cells are made once the whole list is read.
+        Object* ret = Hp().MakeList(items_.data() + list.first, items_.size() - list.first,
+                                    list.tail);
+        items_.resize(list.first);
+        frames_.pop_back();
+        return ret;
     }
 
-    return first_cell_ptr;
-}
\ No newline at end of file
+    Tokenizer* tokenizer_;
+    std::vector<Frame> frames_;
+    // Elements of all open lists, innermost last.
+    std::vector<Object*> items_;
+};
+
+}  // namespace
+
+Object* Read(Tokenizer* tokenizer) {
+    return Reader(tokenizer).Run();
+}
+
+Object* ReadAfterQuote(Tokenizer* tokenizer) {
+    Reader reader(tokenizer);
+    reader.OpenQuote();
+    return reader.Run();
+}
+
+Object* ReadList(Tokenizer* tokenizer) {
+    Reader reader(tokenizer);
+    reader.OpenList();
+    return reader.Run();
+}
@@ -0,0 +1,171 @@
+#include "resolver.h"
+#include "list_helper.h"
+
+namespace {
+
+using Binding = LexicalEnv::Binding;
+
+Symbol* const kQuote = Intern("quote");
+Symbol* const kLambda = Intern("lambda");
+Symbol* const kDefine = Intern("define");
+
+bool IsFunctionDefine(Object* expr) {
+    Object* rest = As<Cell>(expr)->GetSecond();
+    return Is<Cell>(rest) && Is<Cell>(As<Cell>(rest)->GetFirst());
+}
+
+// Names bound by define forms evaluated in the frame of the body, i.e. everywhere except inside
+// quoted data and nested lambdas.
+void CollectDefines(Object* expr, std::unordered_set<const Symbol*>* names) {
+    if (!Is<Cell>(expr)) {
+        return;
+    }
+    Object* head = As<Cell>(expr)->GetFirst();
+    if (head == kQuote || head == kLambda) {
+        return;
+    }
+    if (head == kDefine) {
+        Object* rest = As<Cell>(expr)->GetSecond();
+        if (!Is<Cell>(rest)) {
+            return;
+        }
+        Object* target = As<Cell>(rest)->GetFirst();
+        if (Is<Cell>(target)) {
+            if (Is<Symbol>(As<Cell>(target)->GetFirst())) {
+                names->insert(As<Symbol>(As<Cell>(target)->GetFirst()));
+            }
+            return;
+        }
+        if (Is<Symbol>(target)) {
+            names->insert(As<Symbol>(target));
+        }
+        expr = rest;
+    }
+    while (Is<Cell>(expr)) {
+        CollectDefines(As<Cell>(expr)->GetFirst(), names);
+        expr = As<Cell>(expr)->GetSecond();
+    }
+    CollectDefines(expr, names);
+}
+
+class Resolver {
+public:
+    Resolver(const FrameLayout* layout, Scope* parent) : env_(LexicalEnv(parent).Push(layout)) {
+    }
+
+    Object* Resolve(Object* expr) {
+        if (Is<Symbol>(expr)) {
+            return ResolveSymbol(As<Symbol>(expr));
+        }
+        if (!Is<Cell>(expr)) {
+            return expr;
+        }
+        Object* head = As<Cell>(expr)->GetFirst();
+        if (Is<Symbol>(head) && env_.Lookup(As<Symbol>(head)) == Binding::GLOBAL) {
+            if (head == kQuote || head == kLambda) {
+                return expr;
+            }
+            if (head == kDefine) {
+                // The defined name stays a symbol, function definitions are resolved when the
+                // lambda is created.
+                return IsFunctionDefine(expr) ? expr : ResolveList(expr, 2);
+            }
+        }
+        return ResolveList(expr, 0);
+    }
+
+private:
+    Object* ResolveSymbol(Symbol* symbol) {
+        size_t depth;
+        size_t slot;
+        if (env_.Lookup(symbol, &depth, &slot) != Binding::LOCAL) {
+            return symbol;
+        }
+        return Hp().Make<LocalRef>(symbol, depth, slot);
+    }
+
+    // Resolves the elements of a list except the first skip ones, copying only if needed.
+    Object* ResolveList(Object* list, size_t skip) {
+        std::vector<Object*> items = ObjectToList(list);
+        Object* tail = nullptr;
+        Object* last = list;
+        while (Is<Cell>(As<Cell>(last)->GetSecond())) {
+            last = As<Cell>(last)->GetSecond();
+        }
+        if (As<Cell>(last)->GetSecond()) {
+            tail = items.back();
+            items.pop_back();
+        }
+        bool changed = false;
+        for (size_t i = skip; i < items.size(); ++i) {
+            Object* resolved = Resolve(items[i]);
+            changed |= resolved != items[i];
+            items[i] = resolved;
+        }
+        Object* resolved_tail = Resolve(tail);
+        changed |= resolved_tail != tail;
+        if (!changed) {
+            return list;
+        }
+        Object* ret = resolved_tail;
+        for (size_t i = items.size(); i > 0; --i) {
+            ret = Hp().Make<Cell>(items[i - 1], ret);
+        }
+        return ret;
+    }
+
+    LexicalEnv env_;
+};
+
+}  // namespace
+
+LexicalEnv::LexicalEnv(Scope* scope) {
+    for (Scope* cur = scope; cur && cur->GetLayout(); cur = cur->GetParent()) {
+        frames_.push_back(cur->GetLayout());
+    }
+}
+
+LexicalEnv LexicalEnv::Push(const FrameLayout* layout) const {
+    LexicalEnv inner;
+    inner.frames_.reserve(frames_.size() + 1);
+    inner.frames_.push_back(layout);
+    inner.frames_.insert(inner.frames_.end(), frames_.begin(), frames_.end());
+    return inner;
+}
+
+LexicalEnv::Binding LexicalEnv::Lookup(const Symbol* name, size_t* depth, size_t* slot) const {
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        if (frames_[i]->dynamic.contains(name)) {
+            return Binding::DYNAMIC;
+        }
+        if (auto found = frames_[i]->Slot(name)) {
+            if (depth) {
+                *depth = i;
+                *slot = *found;
+            }
+            return Binding::LOCAL;
+        }
+    }
+    return Binding::GLOBAL;
+}
+
+std::shared_ptr<const FrameLayout> MakeFrameLayout(const std::vector<const Symbol*>& arg_names,
+                                                   const std::vector<Object*>& body) {
+    auto layout = std::make_shared<FrameLayout>();
+    layout->slots = arg_names;
+    for (Object* instruction : body) {
+        CollectDefines(instruction, &layout->dynamic);
+    }
+    return layout;
+}
+
+std::vector<Object*> ResolveBody(const std::vector<Object*>& body, const FrameLayout* layout,
+                                 Scope* parent) {
+    Resolver resolver(layout, parent);
+    std::vector<Object*> resolved;
+    resolved.reserve(body.size());
+    for (Object* instruction : body) {
+        resolved.push_back(resolver.Resolve(instruction));
+    }
+    return resolved;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "object.h"
+
+// Lexical addressing.
+// A lambda body is rewritten once, when the lambda is created: references to the arguments of
+// the lambda and of the enclosing lambdas become LocalRef objects which address frame slots
+// directly. Globals and names introduced by define inside a body stay symbols and are looked up
+// by name.
+
+// Frame layouts visible from some point of the code, innermost first.
+class LexicalEnv {
+public:
+    enum class Binding { LOCAL, DYNAMIC, GLOBAL };
+
+    LexicalEnv() = default;
+    // Layouts of scope and its parents, up to the first scope which is not a lambda frame.
+    explicit LexicalEnv(Scope* scope);
+
+    LexicalEnv Push(const FrameLayout* layout) const;
+    Binding Lookup(const Symbol* name, size_t* depth = nullptr, size_t* slot = nullptr) const;
+
+private:
+    std::vector<const FrameLayout*> frames_;
+};
+
+std::shared_ptr<const FrameLayout> MakeFrameLayout(const std::vector<const Symbol*>& arg_names,
+                                                   const std::vector<Object*>& body);
+
+std::vector<Object*> ResolveBody(const std::vector<Object*>& body, const FrameLayout* layout,
+                                 Scope* parent);
@@ -0,0 +1,174 @@
+#include "scanner.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCHEME_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+size_t SkipClass(const char* data, size_t pos, size_t size, uint8_t mask) {
+    while (pos < size && HasClass(static_cast<unsigned char>(data[pos]), mask)) {
+        ++pos;
+    }
+    return pos;
+}
+
+size_t ScalarSkipSpaces(const char* data, size_t pos, size_t size) {
+    return SkipClass(data, pos, size, SPACE);
+}
+
+size_t ScalarSkipDigits(const char* data, size_t pos, size_t size) {
+    return SkipClass(data, pos, size, DIGIT);
+}
+
+size_t ScalarSkipSymbol(const char* data, size_t pos, size_t size) {
+    return SkipClass(data, pos, size, SYMBOL_CHAR);
+}
+
+const Scanner kScalarScanner{ScalarSkipSpaces, ScalarSkipDigits, ScalarSkipSymbol};
+
+#ifdef SCHEME_SCANNER_X86
+
+// The vector versions build a mask of the bytes inside the run, the first zero bit of a block is
+// the end of the run. The scalar loop finishes the tail shorter than a block.
+
+__m128i InRange128(__m128i v, char low, char high) {
+    // Signed compares: bytes above 0x7f are negative and never in range.
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+}
+
+__m128i Equal128(__m128i v, char c) {
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+__m128i Spaces128(__m128i v) {
+    return _mm_or_si128(Equal128(v, ' '), Equal128(v, '\n'));
+}
+
+__m128i Digits128(__m128i v) {
+    return InRange128(v, '0', '9');
+}
+
+__m128i Symbol128(__m128i v) {
+    __m128i letters = InRange128(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i ret = _mm_or_si128(letters, Digits128(v));
+    ret = _mm_or_si128(ret, InRange128(v, '<', '?'));  // < = > ?
+    ret = _mm_or_si128(ret, InRange128(v, '*', '+'));
+    ret = _mm_or_si128(ret, _mm_or_si128(Equal128(v, '-'), Equal128(v, '/')));
+    return _mm_or_si128(ret, _mm_or_si128(Equal128(v, '#'), Equal128(v, '!')));
+}
+
+template <__m128i (*Run)(__m128i), size_t (*Tail)(const char*, size_t, size_t)>
+size_t Skip128(const char* data, size_t pos, size_t size) {
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        uint32_t outside = ~static_cast<uint32_t>(_mm_movemask_epi8(Run(v))) & 0xffff;
+        if (outside) {
+            return pos + std::countr_zero(outside);
+        }
+    }
+    return Tail(data, pos, size);
+}
+
+const Scanner kSse2Scanner{Skip128<Spaces128, ScalarSkipSpaces>,
+                           Skip128<Digits128, ScalarSkipDigits>,
+                           Skip128<Symbol128, ScalarSkipSymbol>};
+
+#define SCHEME_AVX2 __attribute__((target("avx2")))
+
+SCHEME_AVX2 __m256i InRange256(__m256i v, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(low - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), v));
+}
+
+SCHEME_AVX2 __m256i Equal256(__m256i v, char c) {
+    return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+SCHEME_AVX2 __m256i Spaces256(__m256i v) {
+    return _mm256_or_si256(Equal256(v, ' '), Equal256(v, '\n'));
+}
+
+SCHEME_AVX2 __m256i Digits256(__m256i v) {
+    return InRange256(v, '0', '9');
+}
+
+SCHEME_AVX2 __m256i Symbol256(__m256i v) {
+    __m256i letters = InRange256(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    __m256i ret = _mm256_or_si256(letters, Digits256(v));
+    ret = _mm256_or_si256(ret, InRange256(v, '<', '?'));
+    ret = _mm256_or_si256(ret, InRange256(v, '*', '+'));
+    ret = _mm256_or_si256(ret, _mm256_or_si256(Equal256(v, '-'), Equal256(v, '/')));
+    return _mm256_or_si256(ret, _mm256_or_si256(Equal256(v, '#'), Equal256(v, '!')));
+}
+
+template <__m256i (*Run)(__m256i), size_t (*Tail)(const char*, size_t, size_t)>
+SCHEME_AVX2 size_t Skip256(const char* data, size_t pos, size_t size) {
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        uint32_t outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(Run(v)));
+        if (outside) {
+            return pos + std::countr_zero(outside);
+        }
+    }
+    return Tail(data, pos, size);
+}
+
+const Scanner kAvx2Scanner{Skip256<Spaces256, Skip128<Spaces128, ScalarSkipSpaces>>,
+                           Skip256<Digits256, Skip128<Digits128, ScalarSkipDigits>>,
+                           Skip256<Symbol256, Skip128<Symbol128, ScalarSkipSymbol>>};
+
+#endif
+
+}  // namespace
+
+const Scanner& DefaultScanner() {
+    static const Scanner* scanner = [] {
+        for (ScannerKind kind : {ScannerKind::AVX2, ScannerKind::SSE2}) {
+            if (const Scanner* found = GetScanner(kind)) {
+                return found;
+            }
+        }
+        return &kScalarScanner;
+    }();
+    return *scanner;
+}
+
+const Scanner* GetScanner(ScannerKind kind) {
+    switch (kind) {
+        case ScannerKind::SCALAR:
+            return &kScalarScanner;
+#ifdef SCHEME_SCANNER_X86
+        case ScannerKind::SSE2:
+            return __builtin_cpu_supports("sse2") ? &kSse2Scanner : nullptr;
+        case ScannerKind::AVX2:
+            return __builtin_cpu_supports("avx2") ? &kAvx2Scanner : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+uint32_t ParseDigits(const char* data, size_t size, uint32_t value) {
+    if constexpr (std::endian::native == std::endian::little) {
+        for (; size >= 8; data += 8, size -= 8) {
+            // Combines neighbouring digits into 2-, 4- and finally one 8-digit number.
+            uint64_t chunk;
+            std::memcpy(&chunk, data, 8);
+            chunk -= 0x3030303030303030;
+            chunk = (chunk * 10 + (chunk >> 8)) & 0x00ff00ff00ff00ff;
+            chunk = (chunk * 100 + (chunk >> 16)) & 0x0000ffff0000ffff;
+            chunk = (chunk * 10000 + (chunk >> 32)) & 0xffffffff;
+            value = value * 100000000u + static_cast<uint32_t>(chunk);
+        }
+    }
+    for (; size > 0; ++data, --size) {
+        value = value * 10u + static_cast<uint32_t>(*data - '0');
+    }
+    return value;
+}
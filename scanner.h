@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Character classes of the tokenizer, one lookup per character instead of chains of comparisons.
+enum CharClass : uint8_t {
+    SPACE = 1,
+    DIGIT = 2,
+    SYMBOL_START = 4,
+    SYMBOL_CHAR = 8,
+    DELIMITER = 16,
+};
+
+constexpr std::array<uint8_t, 256> MakeCharClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (int c = 'a'; c <= 'z'; ++c) {
+        classes[c] |= SYMBOL_START | SYMBOL_CHAR;
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        classes[c] |= SYMBOL_START | SYMBOL_CHAR;
+    }
+    for (char c : {'<', '=', '>', '*', '/', '#', '-', '+'}) {
+        classes[static_cast<uint8_t>(c)] |= SYMBOL_START | SYMBOL_CHAR;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        classes[c] |= DIGIT | SYMBOL_CHAR;
+    }
+    for (char c : {'?', '!'}) {
+        classes[static_cast<uint8_t>(c)] |= SYMBOL_CHAR;
+    }
+    for (char c : {' ', '\n'}) {
+        classes[static_cast<uint8_t>(c)] |= SPACE | DELIMITER;
+    }
+    for (char c : {'(', ')'}) {
+        classes[static_cast<uint8_t>(c)] |= DELIMITER;
+    }
+    return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> kCharClasses = MakeCharClasses();
+
+// c is a character or EOF.
+inline bool HasClass(int c, uint8_t mask) {
+    return c != EOF && (kCharClasses[static_cast<uint8_t>(c)] & mask);
+}
+
+/// Scanner
+/// Finds the ends of byte runs for the buffer tokenizer. Besides the scalar loops there are SSE2
+/// and AVX2 versions which classify 16 or 32 bytes at once; the best one supported by the CPU is
+/// picked at run time.
+
+struct Scanner {
+    // Each function returns the index of the first byte in [pos, size) which does not belong to
+    // the run, or size if there is none.
+    size_t (*skip_spaces)(const char* data, size_t pos, size_t size);
+    size_t (*skip_digits)(const char* data, size_t pos, size_t size);
+    size_t (*skip_symbol)(const char* data, size_t pos, size_t size);
+};
+
+enum class ScannerKind { SCALAR, SSE2, AVX2 };
+
+// Fastest scanner supported by the CPU.
+const Scanner& DefaultScanner();
+
+// nullptr if the build or the CPU does not support the kind.
+const Scanner* GetScanner(ScannerKind kind);
+
+// Appends the decimal digits [data, data + size) to value, wrapping around on overflow.
+// Parses eight digits per step.
+uint32_t ParseDigits(const char* data, size_t size, uint32_t value);
@@ -1,43 +1,147 @@
 #include "scheme.h"
 
-#include <sstream>
+#include "image.h"
+#include "mapped_file.h"
+
+#include <string_view>
 
 std::string Interpreter::Run(const std::string& s) {
-    std::stringstream ss{s};
-    Tokenizer tokenizer{&ss};
+    HeapBinding binding(heap_.get());
+    Tokenizer tokenizer{std::string_view(s)};
     Object* node = Read(&tokenizer);
 
     if (!tokenizer.IsEnd()) {
         throw SyntaxError("too much tokens in the line");
     }
 
+    std::string res;
+    StringSink sink(&res);
+    EvalForm(node, &sink);
+    return res;
+}
+
+void Interpreter::Run(std::string_view program, const ResultCallback& on_result) {
+    Tokenizer tokenizer{program};
+    RunForms(&tokenizer, on_result);
+}
+
+void Interpreter::Run(std::istream* in, const ResultCallback& on_result) {
+    Tokenizer tokenizer{in};
+    RunForms(&tokenizer, on_result);
+}
+
+void Interpreter::RunFile(const std::string& path, const ResultCallback& on_result) {
+    MappedFile file(path);
+    Run(file.GetData(), on_result);
+}
+
+void Interpreter::Run(std::string_view program, OutputSink* out) {
+    Tokenizer tokenizer{program};
+    RunForms(&tokenizer, out);
+}
+
+void Interpreter::Run(std::istream* in, OutputSink* out) {
+    Tokenizer tokenizer{in};
+    RunForms(&tokenizer, out);
+}
+
+void Interpreter::RunFile(const std::string& path, OutputSink* out) {
+    MappedFile file(path);
+    Run(file.GetData(), out);
+}
+
+void Interpreter::RunForms(Tokenizer* tokenizer, const ResultCallback& on_result) {
+    HeapBinding binding(heap_.get());
+    StringSink sink(&result_);
+    while (!tokenizer->IsEnd()) {
+        result_.clear();
+        EvalForm(Read(tokenizer), &sink);
+        on_result(result_);
+    }
+}
+
+void Interpreter::RunForms(Tokenizer* tokenizer, OutputSink* out) {
+    HeapBinding binding(heap_.get());
+    while (!tokenizer->IsEnd()) {
+        EvalForm(Read(tokenizer), out);
+        out->Write("\n");
+    }
+}
+
+void Interpreter::EvalForm(Object* node, OutputSink* out) {
     if (!node) {
         throw RuntimeError("can not evaluate empty list");
     }
 
-    Object* eval = node->Eval(base_scope_);
-    std::string res = (eval ? eval->Serialize() : "()");
+    Object* eval = engine_ == Engine::BYTECODE ? Execute(Compile(node, base_scope_), base_scope_)
+                                               : Evaluate(node, base_scope_);
+    // Written before the collection, which may free the result.
+    WriteObject(eval, out);
+    ClearMemory();
+}
+
+void Interpreter::SaveImage(const std::string& path) {
+    ::SaveImage(path, base_scope_, *functions_);
+}
+
+void Interpreter::LoadImage(const std::string& path) {
+    HeapBinding binding(heap_.get());
+    ::LoadImage(path, base_scope_, *functions_);
     ClearMemory();
-    return res;
 }
 
 void Interpreter::ClearMemory() {
-    Hp().CleanUp(base_scope_);
+    heap_->CleanUp(base_scope_);
+}
+
+std::shared_ptr<const Prelude> Interpreter::Snapshot() {
+    std::shared_ptr<Prelude> prelude(new Prelude());
+    prelude->builtins_ = functions_;
+    StringSink sink(&prelude->image_);
+    WriteImage(base_scope_, *functions_, &sink);
+    prelude_ = prelude;
+    return prelude;
 }
 
-Interpreter::Interpreter() {
+void Interpreter::Reset() {
+    Scope* old_scope = base_scope_;
+    MakeBaseScope();
+    // The heap may still remember the old scope, it is deleted once the collection is done.
+    heap_->CleanUpFull(base_scope_);
+    delete old_scope;
+}
+
+void Interpreter::SetGcPauseBudget(std::chrono::microseconds budget) {
+    heap_->SetPauseBudget(budget);
+}
+
+HeapStats Interpreter::GetGcStats() const {
+    return heap_->GetStats();
+}
+
+void Interpreter::SetGcCallback(Heap::CollectionCallback callback) {
+    heap_->SetCollectionCallback(std::move(callback));
+}
+
+Interpreter::Interpreter(Engine engine) : heap_(std::make_unique<Heap>()), engine_(engine) {
     Init();
 }
 
+Interpreter::Interpreter(std::shared_ptr<const Prelude> prelude, Engine engine)
+    : heap_(std::make_unique<Heap>()),
+      engine_(engine),
+      prelude_(std::move(prelude)),
+      functions_(prelude_->builtins_) {
+    MakeBaseScope();
+}
+
 Interpreter::~Interpreter() {
-    for (auto [name, ptr] : functions_) {
-        delete ptr;
-    }
     delete base_scope_;
 }
 
 void Interpreter::Init() {
-    functions_ = {{"quote", new QuoteFunctor()},
+    Builtins primitives;
+    primitives = {{"quote", new QuoteFunctor()},
 
                   {"and", new BooleanFunctor([](bool a, bool b) { return a && b; }, false)},
 
@@ -93,6 +197,18 @@ void Interpreter::Init() {
 
                   {"list-tail", new ListTailFunctor()},
 
+                  {"map", new MapFunctor()},
+
+                  {"for-each", new ForEachFunctor()},
+
+                  {"filter", new FilterFunctor()},
+
+                  {"fold", new FoldFunctor()},
+
+                  {"par-map", new ParallelMapFunctor()},
+
+                  {"gc-stats", new GcStatsFunctor()},
+
                   {"if", new IfOperator()},
 
                   {"define", new DefineOperator()},
@@ -104,6 +220,28 @@ void Interpreter::Init() {
                   {"set-car!", new SetCarOperator()},
 
                   {"set-cdr!", new SetCdrOperator()}};
+    // Shared by the interpreters made from a prelude, so no collector may mark them.
+    for (auto [name, function] : primitives) {
+        Heap::MakePermanent(function);
+    }
+    // Deleted together with the last interpreter or prelude using them.
+    auto release = [](const Builtins* builtins) {
+        for (auto [name, ptr] : *builtins) {
+            delete ptr;
+        }
+        delete builtins;
+    };
+    functions_ = std::shared_ptr<const Builtins>(new Builtins(std::move(primitives)), release);
+    MakeBaseScope();
+}
 
-    base_scope_ = new Scope(functions_, nullptr);
+void Interpreter::MakeBaseScope() {
+    HeapBinding binding(heap_.get());
+    base_scope_ = new Scope();
+    for (auto [name, function] : *functions_) {
+        base_scope_->Define(Intern(name), function);
+    }
+    if (prelude_) {
+        ReadImage(prelude_->image_, base_scope_, *functions_);
+    }
 }
\ No newline at end of file
@@ -2,19 +2,90 @@
 
 #include "tokenizer.h"
 #include "parser.h"
+#include "bytecode.h"
+#include "image.h"
+#include "serializer.h"
+
+class Prelude;
 
 class Interpreter {
 public:
+    enum class Engine { TREE_WALKER, BYTECODE };
+    // Receives the serialized result of every top-level form of a program. The string is reused
+    // for the next result.
+    using ResultCallback = std::function<void(const std::string&)>;
+
+    // Evaluates a single expression.
     std::string Run(const std::string&);
 
-    Interpreter();
+    // Evaluate every top-level form of a program in order, one at a time: a form is read,
+    // evaluated and garbage collected before the next one is read.
+    void Run(std::string_view program, const ResultCallback& on_result);
+    void Run(std::istream* in, const ResultCallback& on_result);
+    // Maps the file into memory instead of reading it.
+    void RunFile(const std::string& path, const ResultCallback& on_result);
+    // Write every result followed by a newline straight into the sink.
+    void Run(std::string_view program, OutputSink* out);
+    void Run(std::istream* in, OutputSink* out);
+    void RunFile(const std::string& path, OutputSink* out);
+
+    // Save the global definitions and load them into another interpreter instead of evaluating
+    // the program again, see image.h.
+    void SaveImage(const std::string& path);
+    void LoadImage(const std::string& path);
+
+    // Saves the global definitions made so far into a prelude, from which interpreters start
+    // without evaluating anything. Each of them loads its own copy of the prelude, so the
+    // globals, lists and closures of the prelude may be changed without affecting the others or
+    // this interpreter.
+    std::shared_ptr<const Prelude> Snapshot();
+    // Drops the global definitions and the changes made since the interpreter was created or
+    // since its last snapshot.
+    void Reset();
+
+    // Bounds the garbage collection pause after every top-level form by collecting the old
+    // generation incrementally, see Heap::SetPauseBudget. Zero collects it in one pause.
+    void SetGcPauseBudget(std::chrono::microseconds budget);
+    // Statistics of the heap of the interpreter. The callback is called after the collection
+    // following every top-level form.
+    HeapStats GetGcStats() const;
+    void SetGcCallback(Heap::CollectionCallback callback);
+
+    explicit Interpreter(Engine engine = Engine::TREE_WALKER);
+    explicit Interpreter(std::shared_ptr<const Prelude> prelude,
+                         Engine engine = Engine::TREE_WALKER);
     ~Interpreter();
 
 private:
+    // Every object made by the interpreter, bound to Hp() while it runs.
+    std::unique_ptr<Heap> heap_;
+    Engine engine_;
     Scope* base_scope_;
+    std::shared_ptr<const Prelude> prelude_;
 
+    void RunForms(Tokenizer* tokenizer, const ResultCallback& on_result);
+    void RunForms(Tokenizer* tokenizer, OutputSink* out);
+    void EvalForm(Object* node, OutputSink* out);
     void ClearMemory();
     void Init();
+    void MakeBaseScope();
+
+    // Shared with the preludes and the interpreters made from this one.
+    std::shared_ptr<const Builtins> functions_;
+    // Output buffer for the callback results.
+    std::string result_;
+};
+
+// Global definitions saved by Interpreter::Snapshot as an image, see image.h.
+class Prelude {
+public:
+    Prelude(const Prelude& other) = delete;
+
+private:
+    friend class Interpreter;
+
+    Prelude() = default;
 
-    std::map<std::string, Object*> functions_;
+    std::shared_ptr<const Builtins> builtins_;
+    std::string image_;
 };
@@ -0,0 +1,97 @@
+#include "serializer.h"
+
+#include <cerrno>
+#include <charconv>
+#include <system_error>
+
+#include <unistd.h>
+
+FdSink::~FdSink() {
+    try {
+        Flush();
+    } catch (const std::system_error&) {
+        // Destructors must not throw, call Flush to see write errors.
+    }
+}
+
+void FdSink::Write(std::string_view data) {
+    if (buffer_.size() + data.size() > kBufferSize) {
+        Flush();
+    }
+    buffer_.append(data);
+}
+
+void FdSink::Flush() {
+    size_t written = 0;
+    while (written < buffer_.size()) {
+        ssize_t res = write(fd_, buffer_.data() + written, buffer_.size() - written);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer_.erase(0, written);
+            throw std::system_error(errno, std::generic_category(), "can not write output");
+        }
+        written += res;
+    }
+    buffer_.clear();
+}
+
+namespace {
+
+void WriteNumber(int64_t value, OutputSink* out) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out->Write(std::string_view(digits, res.ptr - digits));
+}
+
+void WriteAtom(Object* obj, OutputSink* out) {
+    if (!obj) {
+        out->Write("()");
+    } else if (Is<Number>(obj)) {
+        WriteNumber(GetNumber(obj), out);
+    } else if (Is<Boolean>(obj)) {
+        out->Write(As<Boolean>(obj)->GetValue() ? "#t" : "#f");
+    } else if (Is<Symbol>(obj)) {
+        out->Write(As<Symbol>(obj)->GetName());
+    } else {
+        out->Write(obj->Serialize());
+    }
+}
+
+}  // namespace
+
+void WriteObject(Object* obj, OutputSink* out) {
+    // Unprinted rest of every list being printed, innermost last.
+    std::vector<Object*> rests;
+    while (true) {
+        if (Is<Cell>(obj)) {
+            out->Write("(");
+            rests.push_back(As<Cell>(obj)->GetSecond());
+            obj = As<Cell>(obj)->GetFirst();
+            continue;
+        }
+        WriteAtom(obj, out);
+        while (true) {
+            if (rests.empty()) {
+                return;
+            }
+            Object* rest = rests.back();
+            if (!rest) {
+                out->Write(")");
+                rests.pop_back();
+                continue;
+            }
+            if (Is<Cell>(rest)) {
+                out->Write(" ");
+                rests.back() = As<Cell>(rest)->GetSecond();
+                obj = As<Cell>(rest)->GetFirst();
+            } else {
+                out->Write(" . ");
+                rests.back() = nullptr;
+                obj = rest;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "object.h"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/// Output sinks
+/// Destinations the serializer writes to piece by piece, so no intermediate strings are built.
+
+class OutputSink {
+public:
+    virtual void Write(std::string_view data) = 0;
+
+protected:
+    ~OutputSink() = default;
+};
+
+// Appends to a string owned by the caller, which can be reused between calls.
+class StringSink : public OutputSink {
+public:
+    explicit StringSink(std::string* out) : out_(out) {
+    }
+    void Write(std::string_view data) override {
+        out_->append(data);
+    }
+
+private:
+    std::string* out_;
+};
+
+class StreamSink : public OutputSink {
+public:
+    explicit StreamSink(std::ostream* out) : out_(out) {
+    }
+    void Write(std::string_view data) override {
+        out_->write(data.data(), data.size());
+    }
+
+private:
+    std::ostream* out_;
+};
+
+// Buffers output for a file descriptor and writes it in large chunks. The descriptor is not
+// closed. Throws std::system_error if writing fails.
+class FdSink : public OutputSink {
+public:
+    explicit FdSink(int fd) : fd_(fd) {
+    }
+    FdSink(const FdSink& other) = delete;
+    ~FdSink();
+
+    void Write(std::string_view data) override;
+    void Flush();
+
+private:
+    static constexpr size_t kBufferSize = 1 << 16;
+
+    int fd_;
+    std::string buffer_;
+};
+
+/// Serializer
+/// Writes the printed form of obj without recursion, so arbitrarily deep lists can be printed.
+
+void WriteObject(Object* obj, OutputSink* out);
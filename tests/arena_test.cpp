@@ -0,0 +1,70 @@
+#include "arena.h"
+#include "object.h"
+#include "tests/test.h"
+
+#include <set>
+#include <vector>
+
+namespace {
+
+constexpr size_t kCount = 1000;
+
+}  // namespace
+
+TEST_CASE(SlabPoolReusesFreedSlots) {
+    SlabPool pool(Arena::SlotSize(Arena::SizeClass(sizeof(Cell))));
+    std::vector<void*> slots;
+    for (size_t i = 0; i < kCount; ++i) {
+        slots.push_back(pool.Allocate());
+    }
+    std::set<void*> freed(slots.begin(), slots.end());
+    EXPECT_EQ(freed.size(), kCount);
+    for (void* slot : slots) {
+        pool.Free(slot);
+    }
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_TRUE(freed.count(pool.Allocate()));
+    }
+}
+
+#ifndef SCHEME_HEAP_MALLOC
+
+// The slots of dead objects go back to their size class, from the nursery as well as from the
+// sweep of the old generation, and only allocations of that class reuse them.
+TEST_CASE(HeapReusesSweptSlots) {
+    EXPECT_TRUE(Arena::SizeClass(sizeof(Cell)) != Arena::SizeClass(sizeof(Scope)));
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope root;
+    std::set<Object*> young;
+    for (size_t i = 0; i < kCount; ++i) {
+        young.insert(heap.Make<Cell>(MakeNumber(i)));
+    }
+    heap.CleanUp(&root);
+    EXPECT_EQ(heap.GetStats().objects_freed, kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_TRUE(!young.count(heap.Make<Scope>()));
+    }
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_TRUE(young.count(heap.Make<Cell>(MakeNumber(i))));
+    }
+
+    heap.CleanUpFull(&root);
+    std::vector<Object*> items(kCount, MakeNumber(1));
+    Object* list = heap.MakeList(items.data(), items.size());
+    std::set<Object*> old;
+    for (Object* cell = list; cell; cell = As<Cell>(cell)->GetSecond()) {
+        old.insert(cell);
+    }
+    root.Define(Intern("list"), list);
+    heap.CleanUpFull(&root);
+    EXPECT_EQ(heap.GetStats().old_objects, kCount);
+    root.Define(Intern("list"), nullptr);
+    heap.CleanUpFull(&root);
+    EXPECT_EQ(heap.GetStats().old_objects, 0u);
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_TRUE(old.count(heap.Make<Cell>(MakeNumber(i))));
+    }
+}
+
+#endif
@@ -0,0 +1,29 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+}  // namespace
+
+// A malformed call is an error only once it is evaluated.
+TEST_CASE(EmptyHeadInDeadBranch) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        EXPECT_EQ(interpreter.Run("(if #f (() 1) 2)"), "2");
+        interpreter.Run("(define (f) (if #f (() 1) 3))");
+        EXPECT_EQ(interpreter.Run("(f)"), "3");
+    }
+}
+
+TEST_CASE(EmptyHeadEvaluated) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        EXPECT_THROW(interpreter.Run("(() 1)"), RuntimeError);
+        interpreter.Run("(define (g) (() 1))");
+        EXPECT_THROW(interpreter.Run("(g)"), RuntimeError);
+    }
+}
@@ -0,0 +1,64 @@
+#include "error.h"
+#include "functional_object.h"
+#include "object.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+}  // namespace
+
+TEST_CASE(NumberFunctions) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        EXPECT_EQ(interpreter.Run("(+)"), "0");
+        EXPECT_EQ(interpreter.Run("(*)"), "1");
+        EXPECT_EQ(interpreter.Run("(- 7)"), "7");
+        EXPECT_EQ(interpreter.Run("(- 10 1 2 3)"), "4");
+        EXPECT_EQ(interpreter.Run("(max 3 9 4)"), "9");
+        EXPECT_THROW(interpreter.Run("(max)"), RuntimeError);
+        EXPECT_THROW(interpreter.Run("(+ 1 #t)"), RuntimeError);
+    }
+}
+
+// Is and As check a range of type tags, so the classes of every object are its own class and
+// the base classes with a tag range.
+TEST_CASE(TypeTagsMatchClasses) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope scope;
+    Object* cell = heap.Make<Cell>(MakeNumber(1));
+    Object* number = MakeNumber(INT64_MAX);
+    Object* symbol = Intern("x");
+    Object* quote = heap.Make<QuoteFunctor>();
+    Object* if_operator = heap.Make<IfOperator>();
+    Object* car = heap.Make<CarFunctor>();
+    Object* lambda = heap.Make<Lambda>(std::vector<const Symbol*>{Intern("x")},
+                                       std::vector<Object*>{symbol}, &scope);
+
+    EXPECT_TRUE(Is<Cell>(cell) && As<Cell>(cell) == cell);
+    EXPECT_TRUE(Is<Number>(number) && !Is<Cell>(number));
+    EXPECT_TRUE(Is<Symbol>(symbol) && !Is<Number>(symbol));
+    EXPECT_TRUE(Is<Scope>(&scope) && As<Cell>(&scope) == nullptr);
+    for (Object* form : {quote, if_operator}) {
+        EXPECT_TRUE(Is<FunctionalObject>(form));
+        EXPECT_TRUE(!Is<Procedure>(form));
+        EXPECT_TRUE(As<Procedure>(form) == nullptr);
+    }
+    EXPECT_TRUE(Is<QuoteFunctor>(quote) && !Is<IfOperator>(quote));
+    EXPECT_TRUE(Is<IfOperator>(if_operator) && !Is<QuoteFunctor>(if_operator));
+    for (Object* procedure : {car, lambda}) {
+        EXPECT_TRUE(Is<FunctionalObject>(procedure));
+        EXPECT_TRUE(As<Procedure>(procedure) == procedure);
+    }
+    EXPECT_TRUE(Is<Lambda>(lambda) && !Is<Lambda>(car));
+    EXPECT_TRUE(!Is<Cell>(nullptr) && !Is<FunctionalObject>(nullptr));
+    EXPECT_TRUE(As<Lambda>(nullptr) == nullptr);
+    EXPECT_TRUE(!Is<FunctionalObject>(MakeNumber(1)) && !Is<FunctionalObject>(cell));
+}
@@ -0,0 +1,53 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <vector>
+
+TEST_CASE(GcStatsShape) {
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.Run("(map car (gc-stats))"),
+              "(minor-collections major-collections bytes-allocated objects-freed "
+              "young-collected young-promoted last-pause max-pause total-pause mark-time "
+              "sweep-time young-objects old-objects live-after-major allocations)");
+    interpreter.Run("(define (number-entry? entry) (number? (cdr entry)))");
+    interpreter.Run("(define (counters stats) (if (null? (cdr stats)) '() "
+                    "(cons (car stats) (counters (cdr stats)))))");
+    EXPECT_EQ(interpreter.Run("(filter (lambda (e) (not (number-entry? e))) "
+                              "(counters (gc-stats)))"),
+              "()");
+    // Allocations by type.
+    interpreter.Run("(define (last xs) (if (null? (cdr xs)) (car xs) (last (cdr xs))))");
+    EXPECT_EQ(interpreter.Run("(null? (cdr (last (gc-stats))))"), "#f");
+    EXPECT_EQ(interpreter.Run("(filter (lambda (e) (not (number-entry? e))) "
+                              "(cdr (last (gc-stats))))"),
+              "()");
+    // A collection follows every form evaluated so far.
+    EXPECT_EQ(interpreter.Run("(cdr (car (gc-stats)))"), "7");
+    EXPECT_THROW(interpreter.Run("(gc-stats 1)"), RuntimeError);
+}
+
+TEST_CASE(GcCallback) {
+    Interpreter interpreter;
+    std::vector<HeapStats> calls;
+    interpreter.SetGcCallback([&calls](const HeapStats& stats) { calls.push_back(stats); });
+    interpreter.Run("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))");
+    interpreter.Run("(define xs (range 0 100))");
+    interpreter.Run("(range 0 100)");
+    EXPECT_EQ(calls.size(), 3u);
+    EXPECT_EQ(calls.back().minor_collections, 3u);
+    EXPECT_TRUE(calls.back().young_promoted >= 100);
+    EXPECT_TRUE(calls.back().objects_freed >= 100);
+    EXPECT_TRUE(calls.back().total_pause >= calls.back().last_pause);
+    EXPECT_EQ(interpreter.GetGcStats().minor_collections, 3u);
+
+    // The callback stays with the interpreter when it is snapshot, it is not passed on.
+    Interpreter clone(interpreter.Snapshot());
+    interpreter.Run("xs");
+    clone.Run("xs");
+    EXPECT_EQ(calls.size(), 4u);
+
+    interpreter.SetGcCallback(nullptr);
+    interpreter.Run("xs");
+    EXPECT_EQ(calls.size(), 4u);
+}
@@ -0,0 +1,114 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+constexpr const char* kLibrary = R"(
+(define answer 42)
+(define data '(1 (2 3) . 4))
+(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))
+(define (make-counter) (define c 0) (lambda () (set! c (+ c 1)) c))
+(define counter (make-counter))
+(counter)
+)";
+
+class TempFile {
+public:
+    TempFile()
+        : path_(std::filesystem::temp_directory_path() /
+                ("scheme_image_test_" + std::to_string(getpid()))) {
+    }
+    ~TempFile() {
+        std::filesystem::remove(path_);
+    }
+
+    std::string Path() const {
+        return path_.string();
+    }
+    std::string Read() const {
+        std::ifstream in(path_, std::ios::binary);
+        std::ostringstream data;
+        data << in.rdbuf();
+        return data.str();
+    }
+    void Write(const std::string& data) const {
+        std::ofstream(path_, std::ios::binary | std::ios::trunc) << data;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+std::string SaveLibrary(Interpreter::Engine engine, const TempFile& file) {
+    Interpreter interpreter(engine);
+    interpreter.Run(std::string_view(kLibrary), [](const std::string&) {});
+    interpreter.SaveImage(file.Path());
+    return file.Read();
+}
+
+void SetWord(std::string* image, size_t index, uint64_t value) {
+    std::memcpy(image->data() + index * sizeof(value), &value, sizeof(value));
+}
+
+}  // namespace
+
+TEST_CASE(ImageRoundTrip) {
+    for (auto engine : kEngines) {
+        TempFile file;
+        SaveLibrary(engine, file);
+        Interpreter loaded(engine);
+        loaded.LoadImage(file.Path());
+        EXPECT_EQ(loaded.Run("answer"), "42");
+        EXPECT_EQ(loaded.Run("data"), "(1 (2 3) . 4)");
+        EXPECT_EQ(loaded.Run("(fact 10)"), "3628800");
+        EXPECT_EQ(loaded.Run("(counter)"), "2");
+        // Loaded code refers to the globals of the loading interpreter.
+        loaded.Run("(define (fact n) 0)");
+        EXPECT_EQ(loaded.Run("(fact 0)"), "0");
+    }
+}
+
+TEST_CASE(ImageTruncated) {
+    TempFile file;
+    std::string image = SaveLibrary(Interpreter::Engine::BYTECODE, file);
+    for (size_t size = 0; size < image.size(); size += 4) {
+        file.Write(image.substr(0, size));
+        Interpreter interpreter;
+        EXPECT_THROW(interpreter.LoadImage(file.Path()), RuntimeError);
+        EXPECT_THROW(interpreter.Run("answer"), NameError);
+    }
+}
+
+TEST_CASE(ImageCorrupt) {
+    TempFile file;
+    std::string image = SaveLibrary(Interpreter::Engine::TREE_WALKER, file);
+    auto check_rejected = [&](const std::string& corrupt) {
+        file.Write(corrupt);
+        Interpreter interpreter;
+        EXPECT_THROW(interpreter.LoadImage(file.Path()), RuntimeError);
+    };
+    // Magic, version, and the symbol, layout, record and binding counts.
+    for (size_t word = 0; word < 6; ++word) {
+        std::string corrupt = image;
+        SetWord(&corrupt, word, uint64_t{1} << 40);
+        check_rejected(corrupt);
+    }
+    check_rejected(image + std::string(8, '\0'));
+}
+
+TEST_CASE(ImageMissingFile) {
+    Interpreter interpreter;
+    EXPECT_THROW(interpreter.LoadImage("/nonexistent/scheme.img"), std::system_error);
+}
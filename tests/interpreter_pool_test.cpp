@@ -0,0 +1,77 @@
+#include "error.h"
+#include "interpreter_pool.h"
+#include "tests/test.h"
+
+TEST_CASE(PoolRunsPrograms) {
+    Interpreter source;
+    source.Run("(define (square x) (* x x))");
+    source.Run("(define count 0)");
+    InterpreterPool pool(4, source.Snapshot());
+    std::vector<std::string> programs;
+    for (int i = 0; i < 200; ++i) {
+        programs.push_back("(set! count (+ count 1)) (define mine " + std::to_string(i) +
+                           ") (square mine)");
+    }
+    auto results = pool.Submit(std::move(programs));
+    for (int i = 0; i < 200; ++i) {
+        // Every program starts from the prelude again.
+        EXPECT_EQ(results[i].get(),
+                  "1\n" + std::to_string(i) + "\n" + std::to_string(i * i) + "\n");
+    }
+}
+
+TEST_CASE(PoolReportsErrors) {
+    InterpreterPool pool(2);
+    auto failed = pool.Submit("(car 1)");
+    auto undefined = pool.Submit("(define x 1) x");
+    auto later = pool.Submit("x");
+    EXPECT_THROW(failed.get(), RuntimeError);
+    EXPECT_EQ(undefined.get(), "1\n1\n");
+    EXPECT_THROW(later.get(), NameError);
+    EXPECT_EQ(pool.Submit("(+ 1 2)").get(), "3\n");
+}
+
+// The builtins are shared by the interpreters of all workers, whose collectors run at once.
+// Meant to be run with SCHEME_SANITIZER=thread as well.
+TEST_CASE(PoolSharesBuiltins) {
+    for (auto engine : {Interpreter::Engine::TREE_WALKER, Interpreter::Engine::BYTECODE}) {
+        Interpreter source(engine);
+        source.Run("(define (make-adder n) (lambda (x) (+ x n)))");
+        source.Run("(define (compose f g) (lambda (x) (f (g x))))");
+        source.Run("(define inc (make-adder 1))");
+        InterpreterPool pool(4, source.Snapshot(), engine);
+        std::vector<std::string> programs;
+        for (int i = 0; i < 64; ++i) {
+            programs.push_back("((compose inc (make-adder " + std::to_string(i) +
+                               ")) (car (cons 1 '())))");
+        }
+        auto results = pool.Submit(std::move(programs));
+        for (int i = 0; i < 64; ++i) {
+            EXPECT_EQ(results[i].get(), std::to_string(i + 2) + "\n");
+        }
+    }
+}
+
+// Every worker runs major and minor collections while the others do. Meant to be run with
+// SCHEME_SANITIZER=thread as well.
+TEST_CASE(PoolCollectsConcurrently) {
+    Interpreter source;
+    source.Run("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))");
+    source.Run("(define (sum xs) (if (null? xs) 0 (+ (car xs) (sum (cdr xs)))))");
+    auto prelude = source.Snapshot();
+    InterpreterPool pool(4, prelude);
+    // Each task ends with the major collection of Reset. It overlaps the minor collections of
+    // the other workers, the first of which traces their new base scope and the builtins in it.
+    std::string program;
+    for (int i = 0; i < 8; ++i) {
+        program += "(define keep" + std::to_string(i) + " (range 0 2000))\n";
+        program += "(+ (sum (range 0 1000)) (car (cons " + std::to_string(i) + " '())))\n";
+    }
+    std::string expected;
+    StringSink sink(&expected);
+    Interpreter(prelude).Run(std::string_view(program), &sink);
+    auto results = pool.Submit(std::vector<std::string>(32 * pool.Size(), program));
+    for (auto& result : results) {
+        EXPECT_TRUE(result.get() == expected);
+    }
+}
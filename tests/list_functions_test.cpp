@@ -0,0 +1,38 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+}  // namespace
+
+TEST_CASE(ParallelMapMatchesMap) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define (range n acc) (if (= n 0) acc (range (- n 1) (cons n acc))))");
+        interpreter.Run("(define xs (range 5000 '()))");
+        interpreter.Run(
+            "(define (f x) (list x (* x x) (if (= (- x (* 2 (/ x 2))) 0) 'even 'odd)))");
+        EXPECT_EQ(interpreter.Run("(par-map f xs)"), interpreter.Run("(map f xs)"));
+        EXPECT_EQ(interpreter.Run("(par-map (lambda (x) (par-map f (list x x))) '(1 2 3))"),
+                  interpreter.Run("(map (lambda (x) (map f (list x x))) '(1 2 3))"));
+        EXPECT_EQ(interpreter.Run("(par-map f '())"), "()");
+        // Collected as usual once the loop is done.
+        interpreter.Run("(define ys (par-map f xs))");
+        EXPECT_EQ(interpreter.Run("ys"), interpreter.Run("(map f xs)"));
+        EXPECT_THROW(interpreter.Run("(par-map car '(1 2 3))"), RuntimeError);
+    }
+}
+
+TEST_CASE(ListFunctions) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        EXPECT_EQ(interpreter.Run("(map + '(1 2 3) '(10 20))"), "(11 22)");
+        EXPECT_EQ(interpreter.Run("(filter (lambda (x) (> x 1)) '(1 2 3))"), "(2 3)");
+        EXPECT_EQ(interpreter.Run("(fold cons '() '(1 2 3))"), "(3 2 1)");
+        EXPECT_EQ(interpreter.Run("(fold + 0 '(1 2) '(10 20))"), "33");
+    }
+}
@@ -0,0 +1,52 @@
+#include "tests/test.h"
+
+#include <cstdio>
+#include <exception>
+#include <map>
+
+namespace {
+
+std::map<std::string, TestCase::Function>& Cases() {
+    static std::map<std::string, TestCase::Function> cases;
+    return cases;
+}
+
+int failures = 0;
+
+}  // namespace
+
+TestCase::TestCase(const char* name, Function run) {
+    Cases().emplace(name, run);
+}
+
+void ReportFailure(const char* file, int line, const std::string& message) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+    ++failures;
+}
+
+// Runs the cases named on the command line, or all of them.
+int main(int argc, char** argv) {
+    int failed_cases = 0;
+    size_t run_cases = 0;
+    for (const auto& [name, run] : Cases()) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || name == argv[i];
+        }
+        if (!selected) {
+            continue;
+        }
+        ++run_cases;
+        int before = failures;
+        try {
+            run();
+        } catch (const std::exception& e) {
+            ReportFailure(name.c_str(), 0, std::string("unexpected exception: ") + e.what());
+        }
+        bool passed = failures == before;
+        failed_cases += !passed;
+        std::printf("%s %s\n", passed ? "PASS" : "FAIL", name.c_str());
+    }
+    std::printf("%zu cases, %d failed\n", run_cases, failed_cases);
+    return failed_cases == 0 ? 0 : 1;
+}
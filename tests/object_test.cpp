@@ -0,0 +1,177 @@
+#include "list_helper.h"
+#include "object.h"
+#include "tests/test.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE(MakeListBuildsEveryCell) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    std::vector<Object*> items;
+    for (int i = 0; i < 1000; ++i) {
+        items.push_back(MakeNumber(i));
+    }
+    Scope root;
+    root.Define(Intern("list"), heap.MakeList(items.data(), items.size()));
+    EXPECT_EQ(heap.GetStats().young_objects, items.size());
+    heap.CleanUpFull(&root);
+    std::vector<Object*> list = ObjectToList(root.Find(Intern("list")));
+    EXPECT_EQ(list.size(), items.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        EXPECT_EQ(GetNumber(list[i]), static_cast<int64_t>(i));
+    }
+    root.Define(Intern("list"), nullptr);
+    heap.CleanUpFull(&root);
+    EXPECT_EQ(heap.GetStats().old_objects, 0u);
+}
+
+namespace {
+
+Object* MakeRange(Heap* heap, size_t count) {
+    Object* list = nullptr;
+    for (size_t i = count; i > 0; --i) {
+        list = heap->Make<Cell>(MakeNumber(i - 1), list);
+    }
+    return list;
+}
+
+int64_t Sum(Object* list) {
+    int64_t sum = 0;
+    for (; list; list = As<Cell>(list)->GetSecond()) {
+        sum += GetNumber(As<Cell>(list)->GetFirst());
+    }
+    return sum;
+}
+
+}  // namespace
+
+// Marks a heap large enough for the parallel marker, with shared tails and a cycle, and sweeps
+// it during the following allocations.
+TEST_CASE(MajorCollectionSweepsLazily) {
+    constexpr int64_t kCells = 1 << 17;
+    constexpr int64_t kSum = kCells * (kCells - 1) / 2;
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope root;
+    Object* shared = MakeRange(&heap, kCells);
+    root.Define(Intern("a"), heap.Make<Cell>(MakeNumber(1), shared));
+    root.Define(Intern("b"), heap.Make<Cell>(MakeNumber(2), shared));
+    Cell* ring = heap.Make<Cell>(MakeNumber(7));
+    ring->SetSecond(heap.Make<Cell>(MakeNumber(8), ring));
+    root.Define(Intern("ring"), ring);
+    root.Define(Intern("garbage"), MakeRange(&heap, 2 * kCells));
+    heap.CleanUp(&root);
+    EXPECT_EQ(heap.GetStats().old_objects, size_t{3 * kCells + 4});
+
+    // Grows the old generation past the threshold left by the first major collection.
+    root.Define(Intern("garbage"), nullptr);
+    root.Define(Intern("more"), MakeRange(&heap, 4 * kCells));
+    HeapStats before = heap.GetStats();
+    heap.CleanUp(&root);
+    HeapStats after = heap.GetStats();
+    EXPECT_TRUE(after.objects_freed - before.objects_freed < uint64_t{2 * kCells});
+
+    // Every allocation sweeps a few objects.
+    for (int64_t i = 0; i < 7 * kCells / 16 + 1000; ++i) {
+        heap.Make<Cell>(MakeNumber(i));
+    }
+    after = heap.GetStats();
+    EXPECT_EQ(after.major_collections, before.major_collections + 1);
+    EXPECT_EQ(after.objects_freed - before.objects_freed, uint64_t{2 * kCells});
+    EXPECT_EQ(after.old_objects, size_t{5 * kCells + 4});
+
+    heap.CleanUp(&root);
+    EXPECT_EQ(Sum(As<Cell>(root.Find(Intern("a")))->GetSecond()), kSum);
+    EXPECT_EQ(GetNumber(As<Cell>(root.Find(Intern("b")))->GetFirst()), 2);
+    EXPECT_TRUE(As<Cell>(root.Find(Intern("b")))->GetSecond() == shared);
+    EXPECT_EQ(Sum(root.Find(Intern("more"))), 4 * kSum + kCells * kCells * 6);
+    Object* third = As<Cell>(As<Cell>(ring->GetSecond())->GetSecond())->GetFirst();
+    EXPECT_EQ(GetNumber(third), 7);
+}
+
+// A minor collection does not trace old objects, so a young list stored into an old cell
+// survives only through the remembered set filled by the write barrier.
+TEST_CASE(RememberedSetKeepsYoungObjects) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope root;
+    Cell* holder = heap.Make<Cell>(MakeNumber(0));
+    root.Define(Intern("holder"), holder);
+    heap.CleanUp(&root);
+    EXPECT_TRUE(holder->GetGeneration() == Generation::OLD);
+
+    holder->SetSecond(MakeRange(&heap, 100));
+    MakeRange(&heap, 50);
+    HeapStats before = heap.GetStats();
+    heap.CleanUp(&root);
+    HeapStats after = heap.GetStats();
+    EXPECT_EQ(after.last_young_collected, 150u);
+    EXPECT_EQ(after.last_young_promoted, 100u);
+    EXPECT_EQ(after.objects_freed - before.objects_freed, 50u);
+    EXPECT_EQ(after.old_objects, 101u);
+    // The list is freed memory if it was not kept.
+    if (after.last_young_promoted == 100u) {
+        EXPECT_EQ(Sum(holder->GetSecond()), 99 * 100 / 2);
+    }
+}
+
+// Numbers in the 63 bit immediate range and booleans never allocate.
+TEST_CASE(SmallNumbersAreImmediate) {
+    constexpr int64_t kMax = (int64_t{1} << 62) - 1;
+    constexpr int64_t kMin = -(int64_t{1} << 62);
+    Heap heap;
+    HeapBinding binding(&heap);
+    for (int64_t value : {int64_t{0}, int64_t{1}, int64_t{-1}, int64_t{1} << 40, kMax, kMin}) {
+        Object* number = MakeNumber(value);
+        EXPECT_TRUE(IsImmediate(number));
+        EXPECT_TRUE(Is<Number>(number));
+        EXPECT_TRUE(!Is<Cell>(number));
+        EXPECT_TRUE(As<Number>(number) == nullptr);
+        EXPECT_EQ(GetNumber(number), value);
+    }
+    EXPECT_TRUE(MakeBoolean(true) == MakeBoolean(true));
+    EXPECT_TRUE(MakeBoolean(false) != MakeBoolean(true));
+    EXPECT_TRUE(MakeBoolean(false)->GetGeneration() == Generation::PERMANENT);
+    EXPECT_EQ(heap.GetStats().bytes_allocated, 0u);
+
+    for (int64_t value : {kMax + 1, kMin - 1, INT64_MAX, INT64_MIN}) {
+        Object* number = MakeNumber(value);
+        EXPECT_TRUE(!IsImmediate(number));
+        EXPECT_TRUE(Is<Number>(number));
+        EXPECT_EQ(GetNumber(number), value);
+    }
+    HeapStats stats = heap.GetStats();
+    EXPECT_EQ(stats.allocations[static_cast<size_t>(TypeTag::NUMBER)], 4u);
+}
+
+// One permanent symbol per name, also when several threads intern the same names at once.
+TEST_CASE(InternReturnsOneSymbolPerName) {
+    Symbol* symbol = Intern("interned");
+    EXPECT_TRUE(Intern(std::string("inter") + "ned") == symbol);
+    EXPECT_TRUE(Intern("interned?") != symbol);
+    EXPECT_EQ(symbol->GetName(), "interned");
+    EXPECT_TRUE(symbol->GetGeneration() == Generation::PERMANENT);
+
+    constexpr size_t kNames = 1000;
+    std::vector<std::vector<Symbol*>> symbols(4, std::vector<Symbol*>(kNames));
+    std::vector<std::thread> threads;
+    for (auto& interned : symbols) {
+        threads.emplace_back([&interned] {
+            for (size_t i = 0; i < kNames; ++i) {
+                interned[i] = Intern("concurrent-" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < kNames; ++i) {
+        for (auto& interned : symbols) {
+            EXPECT_TRUE(interned[i] == symbols[0][i]);
+        }
+        EXPECT_EQ(symbols[0][i]->GetName(), "concurrent-" + std::to_string(i));
+    }
+}
@@ -0,0 +1,40 @@
+#include "error.h"
+#include "object.h"
+#include "parser.h"
+#include "tests/test.h"
+
+#include <string>
+
+namespace {
+
+Object* ReadString(const std::string& input) {
+    Tokenizer tokenizer(input);
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+// Deeper than the C++ stack would allow a recursive reader.
+TEST_CASE(ReadDeeplyNested) {
+    constexpr int kDepth = 1'000'000;
+    Heap heap;
+    HeapBinding binding(&heap);
+    Object* list = ReadString(std::string(kDepth, '(') + "1" + std::string(kDepth, ')'));
+    int depth = 0;
+    while (Is<Cell>(list)) {
+        list = As<Cell>(list)->GetFirst();
+        ++depth;
+    }
+    EXPECT_EQ(depth, kDepth);
+    EXPECT_EQ(GetNumber(list), 1);
+}
+
+TEST_CASE(ReadErrors) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    EXPECT_THROW(ReadString(std::string(1000, '(')), SyntaxError);
+    EXPECT_THROW(ReadString(")"), SyntaxError);
+    EXPECT_THROW(ReadString("(1 . 2 3)"), SyntaxError);
+    EXPECT_THROW(ReadString("(. 1)"), SyntaxError);
+    EXPECT_THROW(ReadString(""), SyntaxError);
+}
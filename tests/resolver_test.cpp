@@ -0,0 +1,70 @@
+#include "object.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+Object* ReadString(const std::string& input) {
+    Tokenizer tokenizer(input);
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+// An argument defined again in the body is dynamic, also for the lambdas nested in the body, and
+// stays a symbol. Defines in quoted data and in nested lambdas do not count.
+TEST_CASE(DefineShadowsLocalRef) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    Scope root;
+    std::vector<Object*> body = {ReadString("(define x (+ x y))"),
+                                 ReadString("'(define y 1)"),
+                                 ReadString("(lambda () (define y 2) y)"),
+                                 ReadString("(+ x y)")};
+    auto layout = MakeFrameLayout({Intern("x"), Intern("y")}, body);
+    EXPECT_TRUE(layout->dynamic.contains(Intern("x")));
+    EXPECT_TRUE(!layout->dynamic.contains(Intern("y")));
+
+    LexicalEnv env = LexicalEnv().Push(layout.get());
+    size_t depth;
+    size_t slot;
+    EXPECT_TRUE(env.Lookup(Intern("x")) == LexicalEnv::Binding::DYNAMIC);
+    EXPECT_TRUE(env.Lookup(Intern("y"), &depth, &slot) == LexicalEnv::Binding::LOCAL);
+    EXPECT_EQ(depth, 0u);
+    EXPECT_EQ(slot, 1u);
+    FrameLayout inner;
+    inner.slots = {Intern("z")};
+    EXPECT_TRUE(env.Push(&inner).Lookup(Intern("x")) == LexicalEnv::Binding::DYNAMIC);
+    EXPECT_TRUE(env.Push(&inner).Lookup(Intern("y"), &depth, &slot) ==
+                LexicalEnv::Binding::LOCAL);
+    EXPECT_EQ(depth, 1u);
+
+    std::vector<Object*> resolved = ResolveBody(body, layout.get(), &root);
+    std::vector<Object*> sum = ObjectToList(resolved.back());
+    EXPECT_TRUE(sum[1] == Intern("x"));
+    EXPECT_TRUE(Is<LocalRef>(sum[2]));
+}
+
+TEST_CASE(DefineShadowsArgument) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define (scale x) (define x (* x 10)) x)");
+        EXPECT_EQ(interpreter.Run("(scale 2)"), "20");
+        // A closure made before the define sees the new binding once it exists.
+        interpreter.Run("(define (later x) (define (get) x) (define x 7) (get))");
+        EXPECT_EQ(interpreter.Run("(later 1)"), "7");
+        // A define in a nested lambda shadows only in the frame of that lambda.
+        interpreter.Run("(define (outer x) ((lambda () (define x 3) x)) x)");
+        EXPECT_EQ(interpreter.Run("(outer 5)"), "5");
+        interpreter.Run("(define (both x y) (define y (+ x y)) (+ x y))");
+        EXPECT_EQ(interpreter.Run("(both 1 2)"), "4");
+    }
+}
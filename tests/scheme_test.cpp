@@ -0,0 +1,123 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+constexpr const char* kProgram = R"(
+(define x 1)
+(+ x 1)
+'(1 2 . 3)
+
+(define (twice f) (lambda (y) (f (f y))))
+((twice (lambda (y) (* y 3))) x) #t
+x)";
+
+const std::vector<std::string> kResults = {"1", "2", "(1 2 . 3)", "()", "9", "#t", "1"};
+
+class TempFile {
+public:
+    explicit TempFile(const std::string& data)
+        : path_(std::filesystem::temp_directory_path() /
+                ("scheme_run_test_" + std::to_string(getpid()))) {
+        std::ofstream(path_, std::ios::binary | std::ios::trunc) << data;
+    }
+    ~TempFile() {
+        std::filesystem::remove(path_);
+    }
+
+    std::string Path() const {
+        return path_.string();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Each appends the results of the forms run before the first error, which is rethrown.
+void RunBuffer(Interpreter* interpreter, std::string_view program,
+               std::vector<std::string>* results) {
+    interpreter->Run(program, [&](const std::string& result) { results->push_back(result); });
+}
+
+void RunStream(Interpreter* interpreter, const std::string& program,
+               std::vector<std::string>* results) {
+    std::istringstream in(program);
+    interpreter->Run(&in, [&](const std::string& result) { results->push_back(result); });
+}
+
+void RunFile(Interpreter* interpreter, const std::string& path,
+             std::vector<std::string>* results) {
+    interpreter->RunFile(path, [&](const std::string& result) { results->push_back(result); });
+}
+
+}  // namespace
+
+// One callback per form, in order, from every entry point.
+TEST_CASE(RunCallsBackPerForm) {
+    for (auto engine : kEngines) {
+        std::vector<std::string> results;
+        Interpreter buffer(engine);
+        RunBuffer(&buffer, kProgram, &results);
+        EXPECT_TRUE(results == kResults);
+
+        results.clear();
+        Interpreter stream(engine);
+        RunStream(&stream, kProgram, &results);
+        EXPECT_TRUE(results == kResults);
+
+        results.clear();
+        Interpreter file(engine);
+        TempFile program(kProgram);
+        RunFile(&file, program.Path(), &results);
+        EXPECT_TRUE(results == kResults);
+
+        std::string output;
+        StringSink sink(&output);
+        Interpreter sink_file(engine);
+        sink_file.RunFile(program.Path(), &sink);
+        EXPECT_EQ(output, "1\n2\n(1 2 . 3)\n()\n9\n#t\n1\n");
+    }
+}
+
+TEST_CASE(RunEmptyPrograms) {
+    for (auto engine : kEngines) {
+        std::vector<std::string> results;
+        Interpreter interpreter(engine);
+        RunBuffer(&interpreter, "", &results);
+        RunStream(&interpreter, " \n ", &results);
+        TempFile empty("");
+        RunFile(&interpreter, empty.Path(), &results);
+        EXPECT_TRUE(results.empty());
+    }
+}
+
+// Errors keep their types, and the forms before the failing one have been run.
+TEST_CASE(RunReportsErrors) {
+    for (auto engine : kEngines) {
+        std::vector<std::string> results;
+        Interpreter interpreter(engine);
+        EXPECT_THROW(RunBuffer(&interpreter, "(define y 5) (car '())", &results), RuntimeError);
+        EXPECT_THROW(RunStream(&interpreter, "(+ y 1) undefined", &results), NameError);
+        EXPECT_THROW(RunBuffer(&interpreter, "y (1 . 2 3)", &results), SyntaxError);
+        EXPECT_THROW(RunStream(&interpreter, "y )", &results), SyntaxError);
+        TempFile program("(set! y 7) (y)");
+        EXPECT_THROW(RunFile(&interpreter, program.Path(), &results), RuntimeError);
+        EXPECT_THROW(RunFile(&interpreter, "/nonexistent/program.scm", &results),
+                     std::system_error);
+        EXPECT_TRUE(results == std::vector<std::string>({"5", "6", "5", "5", "7"}));
+        EXPECT_EQ(interpreter.Run("y"), "7");
+    }
+}
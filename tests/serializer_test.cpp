@@ -0,0 +1,72 @@
+#include "object.h"
+#include "parser.h"
+#include "serializer.h"
+#include "tests/test.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Prints obj through a StringSink and checks that a StreamSink gets the same output.
+std::string Print(Object* obj) {
+    std::string output;
+    StringSink string_sink(&output);
+    WriteObject(obj, &string_sink);
+    std::ostringstream stream;
+    StreamSink stream_sink(&stream);
+    WriteObject(obj, &stream_sink);
+    EXPECT_TRUE(stream.str() == output);
+    return output;
+}
+
+std::string ReadAndPrint(std::string_view input) {
+    Tokenizer tokenizer(input);
+    return Print(Read(&tokenizer));
+}
+
+}  // namespace
+
+TEST_CASE(PrintLists) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    EXPECT_EQ(ReadAndPrint("()"), "()");
+    EXPECT_EQ(ReadAndPrint("(())"), "(())");
+    EXPECT_EQ(ReadAndPrint("(() (()) ())"), "(() (()) ())");
+    EXPECT_EQ(ReadAndPrint("(1 . ())"), "(1)");
+    EXPECT_EQ(ReadAndPrint("(1 . 2)"), "(1 . 2)");
+    EXPECT_EQ(ReadAndPrint("(1 2 . -3)"), "(1 2 . -3)");
+    EXPECT_EQ(ReadAndPrint("((1 . 2) . (3 . 4))"), "((1 . 2) 3 . 4)");
+    EXPECT_EQ(ReadAndPrint("(1 (2 . 3) . 4)"), "(1 (2 . 3) . 4)");
+    EXPECT_EQ(ReadAndPrint("(#t . #f)"), "(#t . #f)");
+    EXPECT_EQ(ReadAndPrint("(a (b . c) () d . e)"), "(a (b . c) () d . e)");
+}
+
+TEST_CASE(PrintQuotes) {
+    Heap heap;
+    HeapBinding binding(&heap);
+    EXPECT_EQ(ReadAndPrint("'a"), "(quote a)");
+    EXPECT_EQ(ReadAndPrint("'()"), "(quote ())");
+    EXPECT_EQ(ReadAndPrint("''(1 'b)"), "(quote (quote (1 (quote b))))");
+    EXPECT_EQ(ReadAndPrint("(a . 'b)"), "(a quote b)");
+    EXPECT_EQ(ReadAndPrint("'(1 . '2)"), "(quote (1 quote 2))");
+}
+
+// Deeper and longer than the C++ stack would allow a recursive serializer.
+TEST_CASE(PrintDeeplyNested) {
+    constexpr int kDepth = 1'000'000;
+    Heap heap;
+    HeapBinding binding(&heap);
+    Object* nested = MakeNumber(1);
+    Object* long_list = nullptr;
+    for (int i = 0; i < kDepth; ++i) {
+        nested = heap.Make<Cell>(nested, nullptr);
+        long_list = heap.Make<Cell>(MakeNumber(0), long_list);
+    }
+    EXPECT_TRUE(Print(nested) == std::string(kDepth, '(') + "1" + std::string(kDepth, ')'));
+    std::string expected = "(0";
+    for (int i = 1; i < kDepth; ++i) {
+        expected += " 0";
+    }
+    EXPECT_TRUE(Print(long_list) == expected + ")");
+}
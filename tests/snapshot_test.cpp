@@ -0,0 +1,105 @@
+#include "error.h"
+#include "scheme.h"
+#include "tests/test.h"
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+constexpr const char* kPrelude = R"(
+(define n 0)
+(define (inc!) (set! n (+ n 1)) n)
+(define (make-counter) (define c 0) (lambda () (set! c (+ c 1)) c))
+(define counter (make-counter))
+(define data '(1 2 3))
+(define (first-of-data) (car data))
+)";
+
+void RunPrelude(Interpreter* interpreter) {
+    interpreter->Run(std::string_view(kPrelude), [](const std::string&) {});
+}
+
+// Changes the prelude state the way prelude code and programs do and checks that the
+// interpreter sees its own changes.
+void CheckMutable(Interpreter* interpreter) {
+    EXPECT_EQ(interpreter->Run("(inc!)"), "1");
+    EXPECT_EQ(interpreter->Run("(inc!)"), "2");
+    EXPECT_EQ(interpreter->Run("n"), "2");
+    EXPECT_EQ(interpreter->Run("(set! n 10)"), "10");
+    EXPECT_EQ(interpreter->Run("(inc!)"), "11");
+    EXPECT_EQ(interpreter->Run("(counter)"), "1");
+    EXPECT_EQ(interpreter->Run("(counter)"), "2");
+    interpreter->Run("(set-car! data 5)");
+    EXPECT_EQ(interpreter->Run("data"), "(5 2 3)");
+    EXPECT_EQ(interpreter->Run("(first-of-data)"), "5");
+}
+
+}  // namespace
+
+TEST_CASE(SnapshotSourceStaysMutable) {
+    for (auto engine : kEngines) {
+        Interpreter source(engine);
+        RunPrelude(&source);
+        source.Snapshot();
+        CheckMutable(&source);
+    }
+}
+
+TEST_CASE(SnapshotCloneIsMutable) {
+    for (auto engine : kEngines) {
+        Interpreter source(engine);
+        RunPrelude(&source);
+        Interpreter clone(source.Snapshot(), engine);
+        CheckMutable(&clone);
+        // Prelude code resolves the globals of the clone.
+        clone.Run("(define data '(7))");
+        EXPECT_EQ(clone.Run("(first-of-data)"), "7");
+    }
+}
+
+TEST_CASE(SnapshotClonesAreIsolated) {
+    for (auto engine : kEngines) {
+        Interpreter source(engine);
+        RunPrelude(&source);
+        auto prelude = source.Snapshot();
+        Interpreter first(prelude, engine);
+        Interpreter second(prelude, engine);
+        CheckMutable(&first);
+        first.Run("(define extra 1)");
+        EXPECT_EQ(second.Run("n"), "0");
+        EXPECT_EQ(second.Run("data"), "(1 2 3)");
+        EXPECT_THROW(second.Run("extra"), NameError);
+        EXPECT_EQ(source.Run("n"), "0");
+        EXPECT_EQ(source.Run("data"), "(1 2 3)");
+        CheckMutable(&second);
+    }
+}
+
+TEST_CASE(SnapshotReset) {
+    for (auto engine : kEngines) {
+        Interpreter source(engine);
+        RunPrelude(&source);
+        Interpreter clone(source.Snapshot(), engine);
+        CheckMutable(&clone);
+        clone.Run("(define extra 1)");
+        clone.Reset();
+        EXPECT_THROW(clone.Run("extra"), NameError);
+        CheckMutable(&clone);
+    }
+}
+
+// A snapshot of a clone holds the state of the clone.
+TEST_CASE(SnapshotOfClone) {
+    for (auto engine : kEngines) {
+        Interpreter source(engine);
+        RunPrelude(&source);
+        Interpreter clone(source.Snapshot(), engine);
+        clone.Run("(inc!)");
+        clone.Run("(set-car! data 5)");
+        Interpreter next(clone.Snapshot(), engine);
+        EXPECT_EQ(next.Run("(inc!)"), "2");
+        EXPECT_EQ(next.Run("(first-of-data)"), "5");
+        EXPECT_EQ(clone.Run("n"), "1");
+    }
+}
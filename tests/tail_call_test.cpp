@@ -0,0 +1,65 @@
+#include "scheme.h"
+#include "tests/test.h"
+
+#include <string>
+
+namespace {
+
+constexpr Interpreter::Engine kEngines[] = {Interpreter::Engine::TREE_WALKER,
+                                            Interpreter::Engine::BYTECODE};
+
+// Far more iterations than the C++ stack would allow nested calls for.
+constexpr const char* kIterations = "1000000";
+
+}  // namespace
+
+TEST_CASE(TailCallThroughIf) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define (loop n) (if (= n 0) 'done (loop (- n 1))))");
+        EXPECT_EQ(interpreter.Run("(loop " + std::string(kIterations) + ")"), "done");
+        interpreter.Run("(define (count n acc) (if (> n 0) (count (- n 1) (+ acc 2)) acc))");
+        EXPECT_EQ(interpreter.Run("(count " + std::string(kIterations) + " 0)"), "2000000");
+    }
+}
+
+TEST_CASE(TailCallThroughAndOr) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define (loop-or n) (or (= n 0) (and #t (loop-or (- n 1)))))");
+        EXPECT_EQ(interpreter.Run("(loop-or " + std::string(kIterations) + ")"), "#t");
+        interpreter.Run("(define (loop-and n) (and (> n -1) (or (= n 0) (loop-and (- n 1)))))");
+        EXPECT_EQ(interpreter.Run("(loop-and " + std::string(kIterations) + ")"), "#t");
+    }
+}
+
+// The last form of a lambda body, through two functions calling each other.
+TEST_CASE(TailCallThroughBody) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define calls 0)");
+        interpreter.Run("(define (ping n) (set! calls (+ calls 1)) (pong n))");
+        interpreter.Run("(define (pong n) (if (= n 0) calls (ping (- n 1))))");
+        EXPECT_EQ(interpreter.Run("(ping " + std::string(kIterations) + ")"), "1000001");
+    }
+}
+
+// A self tail call reuses the frame of the finished call unless a closure captured it, either
+// in the body or in the arguments of the call.
+TEST_CASE(TailCallKeepsCapturedFrames) {
+    for (auto engine : kEngines) {
+        Interpreter interpreter(engine);
+        interpreter.Run("(define (call-all fs) (if (null? fs) '() (cons ((car fs)) "
+                        "(call-all (cdr fs)))))");
+        interpreter.Run("(define (in-args n acc) (if (= n 0) acc "
+                        "(in-args (- n 1) (cons (lambda () n) acc))))");
+        EXPECT_EQ(interpreter.Run("(call-all (in-args 5 '()))"), "(1 2 3 4 5)");
+        interpreter.Run("(define (in-body n acc) (define f (lambda () n)) "
+                        "(if (= n 0) (cons f acc) (in-body (- n 1) (cons f acc))))");
+        EXPECT_EQ(interpreter.Run("(call-all (in-body 5 '()))"), "(0 1 2 3 4 5)");
+        // Frames which were not captured are still reused in between.
+        interpreter.Run("(define (every-tenth n acc) (if (= n 0) acc (every-tenth (- n 1) "
+                        "(if (= (- n (* 10 (/ n 10))) 0) (cons (lambda () n) acc) acc))))");
+        EXPECT_EQ(interpreter.Run("(call-all (every-tenth 50 '()))"), "(10 20 30 40 50)");
+    }
+}
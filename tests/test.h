@@ -0,0 +1,55 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+/// Tests
+/// Every TEST_CASE registers itself and runs in scheme_tests, which fails if any check failed.
+/// Checks report the failure and let the case go on.
+
+class TestCase {
+public:
+    using Function = void (*)();
+
+    TestCase(const char* name, Function run);
+};
+
+void ReportFailure(const char* file, int line, const std::string& message);
+
+#define TEST_CASE(name)                             \
+    static void name();                             \
+    static TestCase name##_case(#name, name);       \
+    static void name()
+
+#define EXPECT_TRUE(condition)                                       \
+    do {                                                             \
+        if (!(condition)) {                                          \
+            ReportFailure(__FILE__, __LINE__, "failed: " #condition); \
+        }                                                            \
+    } while (false)
+
+#define EXPECT_EQ(actual, expected)                                              \
+    do {                                                                         \
+        auto&& actual_value = (actual);                                          \
+        auto&& expected_value = (expected);                                      \
+        if (!(actual_value == expected_value)) {                                 \
+            std::ostringstream message;                                          \
+            message << #actual << " is " << actual_value << ", expected "        \
+                    << expected_value;                                           \
+            ReportFailure(__FILE__, __LINE__, message.str());                    \
+        }                                                                        \
+    } while (false)
+
+#define EXPECT_THROW(statement, exception)                                        \
+    do {                                                                          \
+        bool thrown = false;                                                      \
+        try {                                                                     \
+            statement;                                                            \
+        } catch (const exception&) {                                              \
+            thrown = true;                                                        \
+        } catch (...) {                                                           \
+        }                                                                         \
+        if (!thrown) {                                                            \
+            ReportFailure(__FILE__, __LINE__, #statement " does not throw " #exception); \
+        }                                                                         \
+    } while (false)
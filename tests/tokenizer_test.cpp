@@ -0,0 +1,136 @@
+#include "error.h"
+#include "scanner.h"
+#include "tests/test.h"
+#include "tokenizer.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr ScannerKind kScannerKinds[] = {ScannerKind::SCALAR, ScannerKind::SSE2,
+                                         ScannerKind::AVX2};
+
+std::string Describe(const Token& token) {
+    if (auto* constant = std::get_if<ConstantToken>(&token)) {
+        return std::to_string(constant->value);
+    }
+    if (auto* symbol = std::get_if<SymbolToken>(&token)) {
+        return "symbol " + std::string(symbol->name);
+    }
+    if (auto* bracket = std::get_if<BracketToken>(&token)) {
+        return *bracket == BracketToken::OPEN ? "(" : ")";
+    }
+    if (auto* boolean = std::get_if<BooleanToken>(&token)) {
+        return boolean->value ? "#t" : "#f";
+    }
+    return std::holds_alternative<QuoteToken>(token) ? "'" : ".";
+}
+
+// Every token until the end of the input or the first error, one per line, and the error.
+std::string Tokenize(Tokenizer* tokenizer) {
+    std::string tokens;
+    try {
+        while (!tokenizer->IsEnd()) {
+            // Read before Next, which invalidates the names of stream symbols.
+            tokens += Describe(tokenizer->GetToken()) + "\n";
+            tokenizer->Next();
+        }
+    } catch (const SyntaxError& error) {
+        tokens += std::string("error: ") + error.what() + "\n";
+    }
+    return tokens;
+}
+
+std::string TokenizeStream(const std::string& input) {
+    std::istringstream in(input);
+    Tokenizer tokenizer(&in);
+    return Tokenize(&tokenizer);
+}
+
+std::string TokenizeBuffer(const std::string& input, const Scanner& scanner) {
+    Tokenizer tokenizer(input, scanner);
+    return Tokenize(&tokenizer);
+}
+
+// Runs which start at every offset of a 32 byte block and end on both sides of it.
+std::vector<std::string> MakeScannerInputs() {
+    std::vector<std::string> bodies = {
+        std::string(70, 'a') + " " + std::string(33, 'z') + "?",
+        "abc-def! x1234567890123456789012345678901234567890 y",
+        "123456789 4294967296 99999999999999999999 0000000000000000000000000000000012",
+        "-12 +7 - + -x +0 -2147483648 +99999999999 (- 1) (+1)",
+        "' a '(1 . 2) ( . ) '\n'x . 'y\n.\n' 'z",
+        "(define (f x) (if (< x 10) #t #f))\n\n   (f   42)",
+    };
+    std::vector<std::string> inputs;
+    for (const auto& body : bodies) {
+        for (size_t pad = 0; pad <= 33; ++pad) {
+            inputs.push_back(std::string(pad, pad % 3 ? ' ' : '\n') + body);
+            inputs.push_back(std::string(pad, 'q') + " " + body);
+        }
+    }
+    return inputs;
+}
+
+}  // namespace
+
+// The SIMD scanners end every run where the scalar one does, from every start position.
+TEST_CASE(ScannersAgree) {
+    const Scanner& scalar = *GetScanner(ScannerKind::SCALAR);
+    for (auto kind : kScannerKinds) {
+        const Scanner* scanner = GetScanner(kind);
+        if (!scanner) {
+            continue;
+        }
+        for (const auto& input : MakeScannerInputs()) {
+            for (size_t pos = 0; pos <= input.size(); ++pos) {
+                const char* data = input.data();
+                EXPECT_EQ(scanner->skip_spaces(data, pos, input.size()),
+                          scalar.skip_spaces(data, pos, input.size()));
+                EXPECT_EQ(scanner->skip_digits(data, pos, input.size()),
+                          scalar.skip_digits(data, pos, input.size()));
+                EXPECT_EQ(scanner->skip_symbol(data, pos, input.size()),
+                          scalar.skip_symbol(data, pos, input.size()));
+            }
+        }
+    }
+}
+
+// Every scanner gives the buffer tokenizer the tokens of the stream tokenizer.
+TEST_CASE(ScannersTokenizeLikeStream) {
+    for (const auto& input : MakeScannerInputs()) {
+        std::string expected = TokenizeStream(input);
+        for (auto kind : kScannerKinds) {
+            if (const Scanner* scanner = GetScanner(kind)) {
+                EXPECT_EQ(TokenizeBuffer(input, *scanner), expected);
+            }
+        }
+    }
+}
+
+TEST_CASE(ParseDigitsWraps) {
+    EXPECT_EQ(ParseDigits("123456789", 9, 0), uint32_t{123456789});
+    EXPECT_EQ(ParseDigits("4294967296", 10, 0), uint32_t{0});
+    EXPECT_EQ(ParseDigits("0000000012", 10, 7), static_cast<uint32_t>(70'000'000'012));
+}
+
+// Same tokens and same errors, including inputs which end in the middle of a token.
+TEST_CASE(BufferTokenizesLikeStream) {
+    const char* inputs[] = {
+        "",       "   \n ",   "(",      "abc",         "abc?!",   "-",        "+",
+        "-5",     "12",       "12abc",  "(1 . 2)",     "'(a b)",  "#t #f",    "#t#f",
+        "#",      "#x",       "(#",     "1.5",         "a.b",     "x\ty",     "\"str\"",
+        "(a, b)", "abc]",     "'",      ". ",          "(1 2",    "1)",       "-x-",
+        "((())",  "+-1",      "--1",    "12 34\n56\n", "a'b",     "0 - 0 +0", "\t",
+    };
+    for (const char* input : inputs) {
+        EXPECT_EQ(TokenizeBuffer(input, DefaultScanner()), TokenizeStream(input));
+    }
+    EXPECT_EQ(TokenizeStream("12"), "12\n");
+    EXPECT_EQ(TokenizeStream("abc"), "symbol abc\n");
+    EXPECT_EQ(TokenizeStream("#"), "error: there should be f or t after #\n");
+    EXPECT_EQ(TokenizeStream("x\ty"), "error: unexpected char\n");
+    EXPECT_EQ(TokenizeStream("\"str\""), "error: unknown symbol\n");
+}
@@ -0,0 +1,105 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+// Pool and index of the worker running on this thread.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { Loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    size_t index = current_pool == this ? current_worker : next_worker_++ % workers_.size();
+    Push(index, std::move(task));
+    Notify(1);
+}
+
+void ThreadPool::Submit(std::vector<Task> tasks) {
+    size_t first = next_worker_.fetch_add(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        Push((first + i) % workers_.size(), std::move(tasks[i]));
+    }
+    Notify(tasks.size());
+}
+
+void ThreadPool::Push(size_t index, Task task) {
+    // Counted before it is queued, so a worker never sleeps while it is in a queue.
+    ++pending_;
+    std::lock_guard lock(workers_[index]->mutex);
+    workers_[index]->tasks.push_back(std::move(task));
+}
+
+void ThreadPool::Notify(size_t count) {
+    {
+        // Orders the update of pending_ with the check of a worker going to sleep.
+        std::lock_guard lock(mutex_);
+    }
+    if (count == 1) {
+        wake_.notify_one();
+    } else {
+        wake_.notify_all();
+    }
+}
+
+bool ThreadPool::Take(size_t index, Task* task) {
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            *task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            *task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Loop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    while (true) {
+        Task task;
+        if (Take(index, &task)) {
+            --pending_;
+            task(index);
+            continue;
+        }
+        std::unique_lock lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
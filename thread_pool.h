@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Thread pool
+/// Every worker has a queue of its own: it takes its newest task first and, once the queue is
+/// empty, steals the oldest task of another worker. Tasks learn the index of the worker running
+/// them, so they can use per-worker state.
+
+class ThreadPool {
+public:
+    // Must not throw.
+    using Task = std::function<void(size_t worker)>;
+
+    explicit ThreadPool(size_t thread_count);
+    ThreadPool(const ThreadPool& other) = delete;
+    // Runs the tasks left in the queues before joining the workers.
+    ~ThreadPool();
+
+    // Queues a task on the calling worker, or on the next worker in turn when called from
+    // outside of the pool.
+    void Submit(Task task);
+    // Spreads the tasks over all workers.
+    void Submit(std::vector<Task> tasks);
+
+    size_t Size() const {
+        return workers_.size();
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Loop(size_t index);
+    bool Take(size_t index, Task* task);
+    void Push(size_t index, Task task);
+    void Notify(size_t count);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_worker_ = 0;
+    // Queued tasks, may be ahead of the queues for a moment.
+    std::atomic<int64_t> pending_ = 0;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+};
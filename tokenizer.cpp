@@ -16,22 +16,60 @@ Token Tokenizer::GetToken() {
 }
 
 Tokenizer::Tokenizer(std::istream* in) : in_(in), is_end_(false) {
-    while (in_->peek() == ' ' || in_->peek() == '\n') {
-        in_->get();
-    }
+    SkipSpaces();
     if (in_->peek() == EOF && in_->eof()) {
         is_end_ = true;
     }
 };
 
-void Tokenizer::Next() {
-    while (in_->peek() == ' ' || in_->peek() == '\n') {
+Tokenizer::Tokenizer(std::string_view buffer, const Scanner& scanner)
+    : buffer_(buffer), scanner_(&scanner), is_end_(false) {
+    SkipSpaces();
+    if (pos_ == buffer_.size()) {
+        is_end_ = true;
+    }
+}
+
+int Tokenizer::Peek() const {
+    if (in_) {
+        return in_->peek();
+    }
+    return pos_ < buffer_.size() ? static_cast<unsigned char>(buffer_[pos_]) : EOF;
+}
+
+int Tokenizer::PeekSecond() {
+    if (in_) {
         in_->get();
+        int second = in_->peek();
+        in_->unget();
+        return second;
+    }
+    return pos_ + 1 < buffer_.size() ? static_cast<unsigned char>(buffer_[pos_ + 1]) : EOF;
+}
+
+int Tokenizer::Get() {
+    if (in_) {
+        return in_->get();
     }
-    char next = in_->peek();
+    return pos_ < buffer_.size() ? static_cast<unsigned char>(buffer_[pos_++]) : EOF;
+}
+
+void Tokenizer::SkipSpaces() {
+    if (in_) {
+        while (HasClass(in_->peek(), SPACE)) {
+            in_->get();
+        }
+        return;
+    }
+    pos_ = scanner_->skip_spaces(buffer_.data(), pos_, buffer_.size());
+}
+
+void Tokenizer::Next() {
+    SkipSpaces();
+    int next = Peek();
     if (next == '#') {
         Boolean();
-    } else if ('0' <= next && next <= '9') {
+    } else if (HasClass(next, DIGIT)) {
         Constant();
     } else if (next == '.') {
         return Dot();
@@ -40,17 +78,14 @@ void Tokenizer::Next() {
     } else if (next == '(' || next == ')') {
         return Bracket();
     } else if (next == '+' || next == '-') {
-        in_->get();
-        char next_1 = in_->peek();
-        in_->unget();
-        if ('0' <= next_1 && next_1 <= '9') {
+        if (HasClass(PeekSecond(), DIGIT)) {
             Constant();
         } else {
             Symbol();
         }
-    } else if (SymbolToken::StartsWith(in_->peek())) {
+    } else if (HasClass(next, SYMBOL_START)) {
         Symbol();
-    } else if (next == EOF && in_->eof()) {
+    } else if (next == EOF && (!in_ || in_->eof())) {
         is_end_ = true;
     } else {
         throw SyntaxError("unknown symbol");
@@ -59,43 +94,54 @@ void Tokenizer::Next() {
 }
 
 void Tokenizer::CheckException() const {
-    if (!GoodChar(in_->peek())) {
+    if (!GoodChar(Peek())) {
         throw SyntaxError("unexpected char");
     }
 }
 
 void Tokenizer::Symbol() {
-    std::string symbol;
-    while (SymbolToken::Contains(in_->peek())) {
-        symbol.push_back(in_->peek());
-        in_->get();
+    if (!in_) {
+        size_t start = pos_;
+        pos_ = scanner_->skip_symbol(buffer_.data(), pos_, buffer_.size());
+        token_o_ = Token{SymbolToken{buffer_.substr(start, pos_ - start)}};
+        return;
     }
-    token_o_ = Token{SymbolToken{symbol}};
+    symbol_.clear();
+    while (HasClass(in_->peek(), SYMBOL_CHAR)) {
+        symbol_.push_back(in_->get());
+    }
+    token_o_ = Token{SymbolToken{symbol_}};
 }
 
 void Tokenizer::Constant() {
     bool is_minus = false;
-    if (in_->peek() == '-' || in_->peek() == '+') {
-        if (in_->get() == '-') {
+    if (Peek() == '-' || Peek() == '+') {
+        if (Get() == '-') {
             is_minus = true;
         }
     }
-    int value{0};
+    // Out of range constants wrap around.
+    uint32_t value{0};
     bool picked = false;
-    while ('0' <= in_->peek() && in_->peek() <= '9') {
+    if (!in_) {
+        size_t end = scanner_->skip_digits(buffer_.data(), pos_, buffer_.size());
+        picked = end != pos_;
+        value = ParseDigits(buffer_.data() + pos_, end - pos_, 0);
+        pos_ = end;
+    }
+    while (HasClass(Peek(), DIGIT)) {
         picked = true;
-        value = 10 * value + (in_->peek() - '0');
-        in_->get();
+        value = 10 * value + (Get() - '0');
     }
     if (!picked) {
         throw SyntaxError("number must have at least one digit");
     }
-    token_o_ = Token{ConstantToken{is_minus ? -value : value}};
+    token_o_ = Token{ConstantToken{static_cast<int>(is_minus ? 0 - value : value)}};
 }
 
 void Tokenizer::Boolean() {
-    in_->get();
-    char next = in_->get();
+    Get();
+    int next = Get();
     if (next != 't' && next != 'f') {
         throw SyntaxError("there should be f or t after #");
     }
@@ -103,32 +149,31 @@ void Tokenizer::Boolean() {
 }
 
 void Tokenizer::Bracket() {
-    token_o_ = Token{in_->get() == '(' ? BracketToken::OPEN : BracketToken::CLOSE};
+    token_o_ = Token{Get() == '(' ? BracketToken::OPEN : BracketToken::CLOSE};
 }
 
 void Tokenizer::Dot() {
-    in_->get();
+    Get();
     token_o_ = Token{DotToken()};
 }
 
 void Tokenizer::Quote() {
-    in_->get();
+    Get();
     token_o_ = Token{QuoteToken()};
 }
 
-bool Tokenizer::GoodChar(char c) const {
-    return c == EOF || c == ' ' || c == '\n' || c == ')' || c == '(' || SymbolToken::Contains(c);
+bool Tokenizer::GoodChar(int c) const {
+    return c == EOF || HasClass(c, DELIMITER | SYMBOL_CHAR);
 }
 
 // Token's definitions
 
 bool SymbolToken::StartsWith(char c) {
-    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '<' || c == '=' || c == '>' ||
-           c == '*' || c == '/' || c == '#' || c == '-' || c == '+';
+    return HasClass(static_cast<unsigned char>(c), SYMBOL_START);
 }
 
 bool SymbolToken::Contains(char c) {
-    return StartsWith(c) || ('0' <= c && c <= '9') || c == '?' || c == '!';
+    return HasClass(static_cast<unsigned char>(c), SYMBOL_CHAR);
 }
 
 bool SymbolToken::operator==(const SymbolToken& other) const {
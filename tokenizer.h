@@ -5,11 +5,15 @@
 #include <istream>
 #include <regex>
 #include <string>
+#include <string_view>
 
 #include "error.h"
+#include "scanner.h"
 
+// The name points into the input buffer, or into the tokenizer for stream input. In the latter
+// case it stays valid until the next call of Tokenizer::Next.
 struct SymbolToken {
-    std::string name;
+    std::string_view name;
 
     bool operator==(const SymbolToken& other) const;
 
@@ -44,6 +48,9 @@ using Token =
 class Tokenizer {
 public:
     Tokenizer(std::istream* in);
+    // Tokenizes a contiguous buffer in place without copying it. The buffer must outlive the
+    // tokenizer and its tokens.
+    explicit Tokenizer(std::string_view buffer, const Scanner& scanner = DefaultScanner());
 
     bool IsEnd();
 
@@ -59,11 +66,22 @@ private:
     void Quote();
     void Boolean();
 
-    bool GoodChar(char) const;
+    // Input access shared by both modes, EOF past the end.
+    int Peek() const;
+    int PeekSecond();
+    int Get();
+    void SkipSpaces();
+
+    bool GoodChar(int) const;
 
     void CheckException() const;
 
-    std::istream* in_;
+    std::istream* in_ = nullptr;
+    std::string_view buffer_;
+    size_t pos_ = 0;
+    const Scanner* scanner_ = nullptr;
+    // Name of the last symbol read from a stream.
+    std::string symbol_;
 
     std::optional<Token> token_o_;
 